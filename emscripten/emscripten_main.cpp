@@ -38,6 +38,16 @@ void vrvToolkit_destructor(Toolkit *tk)
     delete tk;
 }
 
+int vrvToolkit_getCStringLength(Toolkit *tk)
+{
+    return tk->GetCStringLength();
+}
+
+void vrvToolkit_releaseCString(Toolkit *tk)
+{
+    tk->ReleaseCString();
+}
+
 const char *vrvToolkit_getLog(Toolkit *tk)
 {
     tk->SetCString(tk->GetLogString());
@@ -60,6 +70,12 @@ int vrvToolkit_getPageWithElement(Toolkit *tk, const char *xmlId)
     return tk->GetPageWithElement(xmlId);
 }
 
+const char *vrvToolkit_getProfile(Toolkit *tk)
+{
+    tk->SetCString(tk->GetProfile());
+    return tk->GetCString();
+}
+
 double vrvToolkit_getTimeForElement(Toolkit *tk, const char *xmlId)
 {
     return tk->GetTimeForElement(xmlId);
@@ -71,6 +87,24 @@ bool vrvToolkit_loadData(Toolkit *tk, const char *data)
     return tk->LoadData(data);
 }
 
+bool vrvToolkit_indexMdivs(Toolkit *tk, const char *data)
+{
+    tk->ResetLogBuffer();
+    return tk->IndexMdivs(data);
+}
+
+bool vrvToolkit_loadMdiv(Toolkit *tk, int idx)
+{
+    tk->ResetLogBuffer();
+    return tk->LoadMdiv(idx);
+}
+
+const char *vrvToolkit_getMdivIndex(Toolkit *tk)
+{
+    tk->SetCString(tk->GetMdivIndex());
+    return tk->GetCString();
+}
+
 const char *vrvToolkit_getMEI(Toolkit *tk, int page_no, bool score_based)
 {
     tk->SetCString(tk->GetMEI(page_no, score_based));
@@ -97,6 +131,22 @@ const char *vrvToolkit_renderToMidi(Toolkit *tk, const char *c_options)
     return tk->GetCString();
 }
 
+int vrvToolkit_renderToMidiBuffer(Toolkit *tk, const char *c_options)
+{
+    tk->ResetLogBuffer();
+    return tk->RenderToMidiBuffer();
+}
+
+void vrvToolkit_resetProfile(Toolkit *tk)
+{
+    tk->ResetProfile();
+}
+
+const char *vrvToolkit_getBinaryBuffer(Toolkit *tk)
+{
+    return tk->GetBinaryBuffer().data();
+}
+
 const char *vrvToolkit_getElementsAtTime(Toolkit *tk, int millisec)
 {
     tk->SetCString(tk->GetElementsAtTime(millisec));
@@ -119,6 +169,15 @@ void vrvToolkit_redoPagePitchPosLayout(Toolkit *tk)
 {
     tk->RedoPagePitchPosLayout();
 }
+
+bool vrvToolkit_selectReadings(Toolkit *tk, const char *selection)
+{
+    if (!tk->SelectReadings(selection)) {
+        LogError("Could not select the readings.");
+        return false;
+    }
+    return true;
+}
     
 const char *vrvToolkit_renderData(Toolkit *tk, const char *data, const char *options)
 {
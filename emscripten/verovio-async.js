@@ -0,0 +1,108 @@
+
+var verovio = verovio || {};
+
+/***************************************************************************************************************************/
+// Asynchronous toolkit running in one or more WebWorkers (verovio-worker-*.js created by buildToolkit).
+// Every method returns a Promise resolved with the result of the toolkit method of the same name.
+// The methods changing the document or the options are sent to all the workers, each of them holding its own copy of
+// the document. The other methods (e.g., renderPage) are queued and sent to the least busy worker, so the pages of a
+// score can be rendered in parallel with several workers.
+//
+// var tk = new verovio.asyncToolkit("verovio-worker-threads-hum.js", 2);
+// tk.loadData(data).then(function () { return Promise.all([tk.renderPage(1, {}), tk.renderPage(2, {})]); });
+
+verovio.asyncToolkit = function (workerUrl, workerCount) {
+	this.workers = [];
+	this.callbacks = {};
+	this.nextId = 1;
+	workerCount = workerCount || 1;
+	for (var i = 0; i < workerCount; i++) {
+		var worker = new Worker(workerUrl);
+		// The number of calls sent to the worker and not answered yet
+		worker.busy = 0;
+		worker.onmessage = this.onMessage.bind(this, worker);
+		this.workers.push(worker);
+	}
+};
+
+verovio.asyncToolkit.prototype.onMessage = function (worker, event) {
+	var callback = this.callbacks[event.data.id];
+	if (!callback) return;
+	delete this.callbacks[event.data.id];
+	worker.busy--;
+	if (event.data.error !== undefined) {
+		callback.reject(new Error(event.data.error));
+	}
+	else {
+		callback.resolve(event.data.result);
+	}
+};
+
+verovio.asyncToolkit.prototype.post = function (worker, method, args) {
+	var self = this;
+	var id = this.nextId++;
+	worker.busy++;
+	return new Promise(function (resolve, reject) {
+		self.callbacks[id] = { resolve: resolve, reject: reject };
+		worker.postMessage({ id: id, method: method, args: Array.prototype.slice.call(args) });
+	});
+};
+
+// Send the call to all the workers - the promise is resolved with the result of the first one
+verovio.asyncToolkit.prototype.broadcast = function (method, args) {
+	var promises = [];
+	for (var i = 0; i < this.workers.length; i++) {
+		promises.push(this.post(this.workers[i], method, args));
+	}
+	return Promise.all(promises).then(function (results) {
+		return results[0];
+	});
+};
+
+// Send the call to the worker with the fewest calls waiting
+verovio.asyncToolkit.prototype.dispatch = function (method, args) {
+	var worker = this.workers[0];
+	for (var i = 1; i < this.workers.length; i++) {
+		if (this.workers[i].busy < worker.busy) worker = this.workers[i];
+	}
+	return this.post(worker, method, args);
+};
+
+verovio.asyncToolkit.prototype.destroy = function () {
+	for (var i = 0; i < this.workers.length; i++) {
+		this.workers[i].terminate();
+	}
+	this.workers = [];
+	for (var id in this.callbacks) {
+		this.callbacks[id].reject(new Error("The toolkit was destroyed"));
+	}
+	this.callbacks = {};
+};
+
+(function () {
+	var broadcastMethods = ["edit", "indexMdivs", "loadData", "loadMdiv", "redoLayout", "redoPagePitchPosLayout",
+		"resetProfile", "selectReadings", "setOptions"];
+	var dispatchMethods = ["getElementAttr", "getElementsAtTime", "getHumdrum", "getLog", "getMdivIndex", "getMEI",
+		"getPageCount", "getPageWithElement", "getProfile", "getTimeForElement", "getVersion", "renderPage",
+		"renderToMidi", "renderToMidiBinary"];
+	broadcastMethods.forEach(function (method) {
+		verovio.asyncToolkit.prototype[method] = function () {
+			return this.broadcast(method, arguments);
+		};
+	});
+	dispatchMethods.forEach(function (method) {
+		verovio.asyncToolkit.prototype[method] = function () {
+			return this.dispatch(method, arguments);
+		};
+	});
+})();
+
+// The data and the options are loaded by all the workers and the first page is rendered by one of them
+verovio.asyncToolkit.prototype.renderData = function (data, options) {
+	var self = this;
+	return this.broadcast("setOptions", [options]).then(function () {
+		return self.broadcast("loadData", [data]);
+	}).then(function () {
+		return self.dispatch("renderPage", [1, options]);
+	});
+};
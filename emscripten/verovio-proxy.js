@@ -15,54 +15,100 @@ verovio.vrvToolkit.destructor = Module.cwrap('vrvToolkit_destructor', null, ['nu
 // bool edit(Toolkit *ic, const char *editorAction) 
 verovio.vrvToolkit.edit = Module.cwrap('vrvToolkit_edit', 'number', ['number', 'string']);
 
+// const char *getBinaryBuffer(Toolkit *ic)
+verovio.vrvToolkit.getBinaryBuffer = Module.cwrap('vrvToolkit_getBinaryBuffer', 'number', ['number']);
+
+// int getCStringLength(Toolkit *ic)
+verovio.vrvToolkit.getCStringLength = Module.cwrap('vrvToolkit_getCStringLength', 'number', ['number']);
+
 // char *getElementsAtTime(Toolkit *ic, int time )
-verovio.vrvToolkit.getElementsAtTime = Module.cwrap('vrvToolkit_getElementsAtTime', 'string', ['number', 'number']);
+verovio.vrvToolkit.getElementsAtTime = Module.cwrap('vrvToolkit_getElementsAtTime', 'number', ['number', 'number']);
 
 // char *getElementAttr(Toolkit *ic, const char *xmlId )
-verovio.vrvToolkit.getElementAttr = Module.cwrap('vrvToolkit_getElementAttr', 'string', ['number', 'string']);
+verovio.vrvToolkit.getElementAttr = Module.cwrap('vrvToolkit_getElementAttr', 'number', ['number', 'string']);
 
 // char *getLog(Toolkit *ic)
-verovio.vrvToolkit.getLog = Module.cwrap('vrvToolkit_getLog', 'string', ['number']);
+verovio.vrvToolkit.getLog = Module.cwrap('vrvToolkit_getLog', 'number', ['number']);
 
 // char *getMEI(Toolkit *ic, int pageNo, int scoreBased )
-verovio.vrvToolkit.getMEI = Module.cwrap('vrvToolkit_getMEI', 'string', ['number', 'number', 'number']);
+verovio.vrvToolkit.getMEI = Module.cwrap('vrvToolkit_getMEI', 'number', ['number', 'number', 'number']);
 
 // char *getHumdrum(Toolkit *ic)
 verovio.vrvToolkit.getHumdrum = Module.cwrap('vrvToolkit_getHumdrum', 'string');
 
+// char *getMdivIndex(Toolkit *ic)
+verovio.vrvToolkit.getMdivIndex = Module.cwrap('vrvToolkit_getMdivIndex', 'number', ['number']);
+
 // int getPageCount(Toolkit *ic)
 verovio.vrvToolkit.getPageCount = Module.cwrap('vrvToolkit_getPageCount', 'number', ['number']);
 
 // int getPageWithElement(Toolkit *ic, const char *xmlId)
 verovio.vrvToolkit.getPageWithElement = Module.cwrap('vrvToolkit_getPageWithElement', 'number', ['number', 'string']);
 
+// char *getProfile(Toolkit *ic)
+verovio.vrvToolkit.getProfile = Module.cwrap('vrvToolkit_getProfile', 'number', ['number']);
+
 // double getTimeForElement(Toolkit *ic, const char *xmlId)
 verovio.vrvToolkit.getTimeForElement = Module.cwrap('vrvToolkit_getTimeForElement', 'number', ['number', 'string']);
 
 // char *getVersion(Toolkit *ic)
-verovio.vrvToolkit.getVersion = Module.cwrap('vrvToolkit_getVersion', 'string', ['number']);
+verovio.vrvToolkit.getVersion = Module.cwrap('vrvToolkit_getVersion', 'number', ['number']);
 
 // bool loadData(Toolkit *ic, const char *data )
 verovio.vrvToolkit.loadData = Module.cwrap('vrvToolkit_loadData', 'number', ['number', 'string']);
 
+// bool indexMdivs(Toolkit *ic, const char *data )
+verovio.vrvToolkit.indexMdivs = Module.cwrap('vrvToolkit_indexMdivs', 'number', ['number', 'string']);
+
+// bool loadMdiv(Toolkit *ic, int idx )
+verovio.vrvToolkit.loadMdiv = Module.cwrap('vrvToolkit_loadMdiv', 'number', ['number', 'number']);
+
 // void redoLayout(Toolkit *ic)
 verovio.vrvToolkit.redoLayout = Module.cwrap('vrvToolkit_redoLayout', null, ['number']);
 
 // void redoPagePitchPosLayout(Toolkit *ic)
 verovio.vrvToolkit.redoPagePitchPosLayout = Module.cwrap('vrvToolkit_redoPagePitchPosLayout', null, ['number']);
 
+// bool selectReadings(Toolkit *ic, const char *selection)
+verovio.vrvToolkit.selectReadings = Module.cwrap('vrvToolkit_selectReadings', 'number', ['number', 'string']);
+
 // char *renderData(Toolkit *ic, const char *data, const char *options )
-verovio.vrvToolkit.renderData = Module.cwrap('vrvToolkit_renderData', 'string', ['number', 'string', 'string']);
+verovio.vrvToolkit.renderData = Module.cwrap('vrvToolkit_renderData', 'number', ['number', 'string', 'string']);
 
 // char *renderPage(Toolkit *ic, int pageNo, const char *rendering_options )
-verovio.vrvToolkit.renderPage = Module.cwrap('vrvToolkit_renderPage', 'string', ['number', 'number', 'string']);
+verovio.vrvToolkit.renderPage = Module.cwrap('vrvToolkit_renderPage', 'number', ['number', 'number', 'string']);
 
 // char *renderToMidi(Toolkit *ic, const char *rendering_options )
-verovio.vrvToolkit.renderToMidi = Module.cwrap('vrvToolkit_renderToMidi', 'string', ['number', 'string']);
+verovio.vrvToolkit.renderToMidi = Module.cwrap('vrvToolkit_renderToMidi', 'number', ['number', 'string']);
+
+// void releaseCString(Toolkit *ic)
+verovio.vrvToolkit.releaseCString = Module.cwrap('vrvToolkit_releaseCString', null, ['number']);
+
+// int renderToMidiBuffer(Toolkit *ic, const char *rendering_options )
+verovio.vrvToolkit.renderToMidiBuffer = Module.cwrap('vrvToolkit_renderToMidiBuffer', 'number', ['number', 'string']);
+
+// void resetProfile(Toolkit *ic)
+verovio.vrvToolkit.resetProfile = Module.cwrap('vrvToolkit_resetProfile', null, ['number']);
 
 // void setOptions(Toolkit *ic, const char *options) 
 verovio.vrvToolkit.setOptions = Module.cwrap('vrvToolkit_setOptions', null, ['number', 'string']);
 
+// The strings returned are decoded directly from the buffer owned by the toolkit
+verovio.textDecoder = (typeof TextDecoder !== "undefined") ? new TextDecoder("utf-8") : null;
+
+// string getCString(Toolkit *ic, const char *cString)
+verovio.vrvToolkit.getCString = function (ptr, cString) {
+	if (verovio.textDecoder) {
+		var length = verovio.vrvToolkit.getCStringLength(ptr);
+		// A shared heap (threaded version) cannot be decoded directly and has to be copied first
+		if ((typeof SharedArrayBuffer !== "undefined") && (Module.HEAPU8.buffer instanceof SharedArrayBuffer)) {
+			return verovio.textDecoder.decode(Module.HEAPU8.slice(cString, cString + length));
+		}
+		return verovio.textDecoder.decode(Module.HEAPU8.subarray(cString, cString + length));
+	}
+	return Pointer_stringify(cString);
+};
+
 // A pointer to the object - only one instance can be created for now
 verovio.ptr = 0;
 
@@ -97,15 +143,15 @@ verovio.toolkit.prototype.edit = function (editorAction) {
 };
 
 verovio.toolkit.prototype.getElementsAtTime = function (millisec) {
-	return JSON.parse(verovio.vrvToolkit.getElementsAtTime(this.ptr, millisec));
+	return JSON.parse(verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getElementsAtTime(this.ptr, millisec)));
 };
 
 verovio.toolkit.prototype.getLog = function () {
-	return verovio.vrvToolkit.getLog(this.ptr);
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getLog(this.ptr));
 };
 
 verovio.toolkit.prototype.getMEI = function (pageNo, scoreBased) {
-	return verovio.vrvToolkit.getMEI(this.ptr, pageNo, scoreBased);
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getMEI(this.ptr, pageNo, scoreBased));
 };
 
 verovio.toolkit.prototype.getHumdrum = function () {
@@ -120,18 +166,34 @@ verovio.toolkit.prototype.getPageWithElement = function (xmlId) {
 	return verovio.vrvToolkit.getPageWithElement(this.ptr, xmlId);
 };
 
+verovio.toolkit.prototype.getProfile = function () {
+	return JSON.parse(verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getProfile(this.ptr)));
+};
+
 verovio.toolkit.prototype.getTimeForElement = function (xmlId) {
 	return verovio.vrvToolkit.getTimeForElement(this.ptr, xmlId);
 };
 
 verovio.toolkit.prototype.getVersion = function () {
-	return verovio.vrvToolkit.getVersion(this.ptr);
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getVersion(this.ptr));
 };
 
 verovio.toolkit.prototype.loadData = function (data) {
 	return verovio.vrvToolkit.loadData(this.ptr, data);
 };
 
+verovio.toolkit.prototype.indexMdivs = function (data) {
+	return verovio.vrvToolkit.indexMdivs(this.ptr, data);
+};
+
+verovio.toolkit.prototype.loadMdiv = function (idx) {
+	return verovio.vrvToolkit.loadMdiv(this.ptr, idx);
+};
+
+verovio.toolkit.prototype.getMdivIndex = function () {
+	return JSON.parse(verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getMdivIndex(this.ptr)));
+};
+
 verovio.toolkit.prototype.redoLayout = function () {
 	verovio.vrvToolkit.redoLayout(this.ptr);
 }
@@ -140,12 +202,20 @@ verovio.toolkit.prototype.redoPagePitchPosLayout = function () {
 	verovio.vrvToolkit.redoPagePitchPosLayout(this.ptr);
 }
 
+verovio.toolkit.prototype.selectReadings = function (selection) {
+	return verovio.vrvToolkit.selectReadings(this.ptr, JSON.stringify(selection));
+};
+
+verovio.toolkit.prototype.releaseBuffer = function () {
+	verovio.vrvToolkit.releaseCString(this.ptr);
+};
+
 verovio.toolkit.prototype.renderData = function (data, options) {
 	if (typeof options === 'string') {
 		console.warn("DEPRECATION WARNING: Passing a String to renderData will be removed in next version of Verovio. Pass a JSON Object instead.");
 		verovio.vrvToolkit.renderData(this.ptr, data, options);
 	}
-	return verovio.vrvToolkit.renderData(this.ptr, data, JSON.stringify(options));
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.renderData(this.ptr, data, JSON.stringify(options)));
 };
 
 verovio.toolkit.prototype.renderPage = function (pageNo, options) {
@@ -153,7 +223,7 @@ verovio.toolkit.prototype.renderPage = function (pageNo, options) {
 		console.warn("DEPRECATION WARNING: Passing a String to renderPage will be removed in next version of Verovio. Pass a JSON Object instead.");
 		verovio.vrvToolkit.renderPage(this.ptr, pageNo, options);
 	}
-	return verovio.vrvToolkit.renderPage(this.ptr, pageNo, JSON.stringify(options));
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.renderPage(this.ptr, pageNo, JSON.stringify(options)));
 };
 
 verovio.toolkit.prototype.renderToMidi = function (options) {
@@ -161,7 +231,18 @@ verovio.toolkit.prototype.renderToMidi = function (options) {
 		console.warn("DEPRECATION WARNING: Passing a String to renderToMidi will be removed in next version of Verovio. Pass a JSON Object instead.");
 		verovio.vrvToolkit.renderToMidi(this.ptr, options);
 	}
-	return verovio.vrvToolkit.renderToMidi(this.ptr, JSON.stringify(options));
+	return verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.renderToMidi(this.ptr, JSON.stringify(options)));
+};
+
+verovio.toolkit.prototype.renderToMidiBinary = function (options) {
+	var size = verovio.vrvToolkit.renderToMidiBuffer(this.ptr, JSON.stringify(options));
+	var ptr = verovio.vrvToolkit.getBinaryBuffer(this.ptr);
+	// Copy the buffer out of the heap since it is overwritten by the next call
+	return Module.HEAPU8.slice(ptr, ptr + size);
+};
+
+verovio.toolkit.prototype.resetProfile = function () {
+	verovio.vrvToolkit.resetProfile(this.ptr);
 };
 
 verovio.toolkit.prototype.setOptions = function (options) {
@@ -175,7 +256,7 @@ verovio.toolkit.prototype.setOptions = function (options) {
 };
 
 verovio.toolkit.prototype.getElementAttr = function (xmlId) {
-	return JSON.parse(verovio.vrvToolkit.getElementAttr(this.ptr, xmlId));
+	return JSON.parse(verovio.vrvToolkit.getCString(this.ptr, verovio.vrvToolkit.getElementAttr(this.ptr, xmlId)));
 };
 
 /***************************************************************************************************************************/
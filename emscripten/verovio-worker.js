@@ -0,0 +1,72 @@
+
+/***************************************************************************************************************************/
+// Message handler for running the toolkit in a WebWorker - see verovio-async.js for the API using it.
+// Each message is { id, method, args } with the name of a verovio.toolkit method and its arguments.
+// The reply is { id, result } or { id, error } once the call is done.
+// The threads of the threaded version also load this script and must keep their own message handler.
+
+if ((typeof ENVIRONMENT_IS_PTHREAD === "undefined") || !ENVIRONMENT_IS_PTHREAD) {
+
+	verovio.worker = verovio.worker || {};
+
+	verovio.worker.toolkit = null;
+
+	// The messages received before the runtime is initialized
+	verovio.worker.pending = [];
+
+	verovio.worker.ready = false;
+
+	verovio.worker.handle = function (data) {
+		try {
+			// The toolkit is created with the first call
+			if (!verovio.worker.toolkit) {
+				verovio.worker.toolkit = new verovio.toolkit();
+			}
+			var tk = verovio.worker.toolkit;
+			if (typeof tk[data.method] !== "function") {
+				throw new Error("Unknown toolkit method '" + data.method + "'");
+			}
+			var result = tk[data.method].apply(tk, data.args || []);
+			// Binary results are transferred and not copied
+			if (result instanceof Uint8Array) {
+				postMessage({ id: data.id, result: result }, [result.buffer]);
+			}
+			else {
+				postMessage({ id: data.id, result: result });
+			}
+		}
+		catch (e) {
+			postMessage({ id: data.id, error: (e && e.message) ? e.message : String(e) });
+		}
+	};
+
+	verovio.worker.start = function () {
+		verovio.worker.ready = true;
+		var pending = verovio.worker.pending;
+		verovio.worker.pending = [];
+		for (var i = 0; i < pending.length; i++) {
+			verovio.worker.handle(pending[i]);
+		}
+	};
+
+	self.onmessage = function (event) {
+		if (verovio.worker.ready) {
+			verovio.worker.handle(event.data);
+		}
+		else {
+			verovio.worker.pending.push(event.data);
+		}
+	};
+
+	// The WASM versions are initialized asynchronously
+	if (Module["calledRun"]) {
+		verovio.worker.start();
+	}
+	else {
+		var onRuntimeInitialized = Module["onRuntimeInitialized"];
+		Module["onRuntimeInitialized"] = function () {
+			if (onRuntimeInitialized) onRuntimeInitialized();
+			verovio.worker.start();
+		};
+	}
+}
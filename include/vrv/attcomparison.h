@@ -241,6 +241,34 @@ private:
     double m_time;
 };
 
+//----------------------------------------------------------------------------
+// InterfaceComparisonAny
+//----------------------------------------------------------------------------
+
+/**
+ * This class evaluates if the object implements one of the interfaces.
+ */
+class InterfaceComparisonAny : public AttComparison {
+
+public:
+    InterfaceComparisonAny(std::vector<InterfaceId> interfaceIds) : AttComparison(OBJECT)
+    {
+        m_interfaceIds = interfaceIds;
+    }
+
+    virtual bool operator()(Object *object)
+    {
+        std::vector<InterfaceId>::iterator iter;
+        for (iter = m_interfaceIds.begin(); iter != m_interfaceIds.end(); ++iter) {
+            if (object->HasInterface(*iter)) return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<InterfaceId> m_interfaceIds;
+};
+
 } // namespace vrv
 
 #endif
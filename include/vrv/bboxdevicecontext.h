@@ -127,6 +127,13 @@ public:
     virtual void EndPage();
     ///@}
 
+    /**
+     * Geometry-only counterpart of DrawMusicText for a single SMuFL glyph.
+     * The position is given in logical coordinates and the extents are taken from the glyph metrics
+     * without going through the font stack. They are cached in the object being drawn.
+     */
+    void DrawMusicGlyph(wchar_t code, int x, int y, int fontSize, bool setSmuflGlyph);
+
     bool UpdateHorizontalValues() { return (m_update != BBOX_VERTICAL_ONLY); }
     bool UpdateVerticalValues() { return (m_update != BBOX_HORIZONTAL_ONLY); }
 
@@ -155,6 +162,11 @@ private:
     View *m_view;
 
     void UpdateBB(int x1, int y1, int x2, int y2, wchar_t glyph = 0);
+
+    /**
+     * Update the bounding boxes with values already in logical coordinates
+     */
+    void UpdateLogicalBB(int x1, int y1, int x2, int y2, wchar_t glyph, int fontSize);
 };
 
 } // namespace vrv
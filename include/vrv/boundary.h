@@ -72,6 +72,11 @@ public:
      */
     virtual int PrepareFloatingGrps(FunctorParams *functoParams);
 
+    /**
+     * See Object::CalcMaxMeasureDuration
+     */
+    virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+
 protected:
     //
 private:
@@ -16,6 +16,7 @@ namespace vrv {
 
 class Doc;
 class Glyph;
+class MusicFont;
 
 //----------------------------------------------------------------------------
 // BoundingBox
@@ -61,6 +62,19 @@ public:
     int GetBoundingBoxGlyphFontSize() const { return m_smuflGlyphFontSize; }
     ///@}
 
+    /**
+     * @name Set and get the cached extents of a single SMuFL glyph drawn by the object.
+     * The extents are relative to the glyph position and are used by the geometry-only bounding box calculation.
+     * They are not reset with the bounding box and remain valid as long as the glyph, the font, and the font size do
+     * not change.
+     */
+    ///@{
+    void SetCachedGlyphExtents(
+        wchar_t smuflGlyph, const MusicFont *musicFont, int fontSize, int x1, int y1, int x2, int y2);
+    bool GetCachedGlyphExtents(
+        wchar_t smuflGlyph, const MusicFont *musicFont, int fontSize, int &x1, int &y1, int &x2, int &y2) const;
+    ///@}
+
     /**
      * Reset the bounding box values
      */
@@ -257,9 +271,14 @@ private:
     int m_smuflGlyphFontSize;
 
     /**
-     * Buffer for De-Casteljau algorithm
+     * The glyph, font, font size, and extents cached by SetCachedGlyphExtents
      */
-    static int s_deCasteljau[4][4];
+    ///@{
+    wchar_t m_cachedGlyph;
+    const MusicFont *m_cachedGlyphFont;
+    int m_cachedGlyphFontSize;
+    int m_cachedGlyphExtents[4];
+    ///@}
 };
 
 } // namespace vrv
@@ -19,6 +19,7 @@
 namespace vrv {
 
 class Glyph;
+class MusicFont;
 class Object;
 class View;
 
@@ -48,6 +49,7 @@ public:
         m_drawingBoundingBoxes = false;
         m_isDeactivatedX = false;
         m_isDeactivatedY = false;
+        m_musicFont = NULL;
     }
     virtual ~DeviceContext(){};
     virtual ClassId GetClassId() const;
@@ -73,6 +75,15 @@ public:
     virtual void SetLogicalOrigin(int x, int y) = 0;
     ///}
 
+    /**
+     * @name Setter and getter for the music font of the document being drawn (not owned)
+     * It is set by the View when drawing a page.
+     */
+    ///@{
+    void SetMusicFont(MusicFont *musicFont) { m_musicFont = musicFont; }
+    MusicFont *GetMusicFont() { return m_musicFont; }
+    ///@}
+
     /**
      * @name Getters for text extend (non-virtual)
      */
@@ -214,6 +225,9 @@ protected:
     std::stack<Brush> m_brushStack;
     std::stack<FontInfo *> m_fontStack;
 
+    /** The music font of the glyphs */
+    MusicFont *m_musicFont;
+
     /** flag for indicating if the graphic is deactivated */
     bool m_isDeactivatedX;
     bool m_isDeactivatedY;
@@ -11,13 +11,16 @@
 #include "devicecontextbase.h"
 #include "scoredef.h"
 #include "style.h"
+#include "timemap.h"
 
+class MidiEventList;
 class MidiFile;
 
 namespace vrv {
 
 class FontInfo;
 class Glyph;
+class MusicFont;
 class Page;
 class Score;
 
@@ -89,8 +92,28 @@ public:
     */
     int GetPageCount() const;
 
+    /**
+     * Get the page count estimated from the pages already cast off when the document is cast off incrementally.
+     * The pending page is not counted as such. Return the page count when the cast off is complete.
+     */
+    int GetEstimatedPageCount() const;
+
     bool GetMidiExportDone() const;
 
+    /**
+     * Return the timemap built by the MIDI export.
+     */
+    const Timemap *GetTimemap() const { return &m_timemap; }
+
+    /**
+     * @name Setter and getter for the music font of the document (not owned)
+     * The default font of the resources is used when the document is created.
+     */
+    ///@{
+    void SetMusicFont(MusicFont *musicFont) { m_musicFont = musicFont; }
+    MusicFont *GetMusicFont() const { return m_musicFont; }
+    ///@}
+
     /**
      * @name Get the height or width for a glyph taking into account the staff and grace sizes
      */
@@ -136,6 +159,14 @@ public:
     FontInfo *GetDrawingLyricFont(int staffSize);
     ///@}
 
+    /**
+     * @name Return the point size of the SMuFL or lyric font for a staff size, without changing the member font
+     */
+    ///@{
+    int GetDrawingSmuflFontSize(int staffSize, bool graceSize) const;
+    int GetDrawingLyricFontSize(int staffSize) const;
+    ///@}
+
     /**
      * @name Setters for the page dimensions and margins
      */
@@ -163,6 +194,11 @@ public:
      * @name Getters for the page dimensions and margins
      */
     ///@{
+    int GetPageHeight() const { return m_pageHeight; }
+    int GetPageWidth() const { return m_pageWidth; }
+    short GetPageLeftMar() const { return m_pageLeftMar; }
+    short GetPageRightMar() const { return m_pageRightMar; }
+    short GetPageTopMar() const { return m_pageTopMar; }
     short GetSpacingStaff() const { return m_spacingStaff; }
     short GetSpacingSystem() const { return m_spacingSystem; }
     ///@}
@@ -213,7 +249,9 @@ public:
 
     /**
      * Export the document to a MIDI file.
-     * Run trough all the layer and fill the midi file content.
+     * The notes are collected in a single pass and the events of each staff are then generated and sorted
+     * concurrently before being added to the midi file track by track.
+     * The notes of the measures that have not been modified since the previous export are taken from the cache.
      */
     void ExportMIDI(MidiFile *midiFile);
 
@@ -225,12 +263,30 @@ public:
      */
     void CollectScoreDefs(bool force = false);
 
+    /**
+     * Set the initial scoreDef of each page from the page pageIdx only.
+     * The scoreDefs have to be collected for all the pages before, and the previous page cannot have been changed.
+     */
+    void CollectScoreDefsFromPage(int pageIdx);
+
     /**
      * Prepare the document for drawing.
      * This sets drawing pointers and value and needs to be done after loading and any editing.
      * For example, it sets the approriate values for the lyrics connectors
+     * The preparation is done for the root (the document by default). Without the document-wide steps, the root has
+     * to be a measure and it is prepared on its own after having been changed: the measure repeats and the boundaries
+     * are not prepared again and false is returned if the content of the measure points outside it. The preparation
+     * is then not complete and has to be done again for the whole document.
      */
-    void PrepareDrawing();
+    bool PrepareDrawing(Object *root = NULL, bool docWideSteps = true);
+
+    /**
+     * Return true if the drawing preparation of the measures depends on other measures, i.e., if slurs, ties or
+     * syllable connectors go across their boundaries, if a control event of another measure points to them or if
+     * they have measure repeats.
+     * It looks at the prepared content and has to be called before the measures are changed.
+     */
+    bool HasDrawingLinksAcross(const std::vector<Measure *> &measures);
 
     /**
      * Casts off the entire document.
@@ -238,18 +294,66 @@ public:
      */
     void CastOffDoc();
 
+    /**
+     * Casts off the document incrementally.
+     * Only the first page is cast off and the rest of the content is kept in a pending page at the end of the
+     * document. It is then cast off on demand with Doc::CastOffPendingPages.
+     */
+    void CastOffDocIncrementally();
+
+    /**
+     * Cast off the pending content until the page pageIdx is complete (-1 for casting off everything).
+     * Does nothing if the document was not cast off incrementally or if the cast off is complete.
+     */
+    void CastOffPendingPages(int pageIdx = -1);
+
+    /**
+     * Cast off the pending content until the object is on a complete page.
+     */
+    void CastOffPendingPagesTo(Object *object);
+
+    /**
+     * Casts off the document again from the page, keeping the pages before it.
+     * The content of the page and of the following ones is moved to a pending page and cast off as in
+     * Doc::CastOffDocIncrementally, entirely unless incrementally is true.
+     * Return false and leave the document unchanged if the pages before cannot be kept (e.g., if the longest duration
+     * changed or if the document was not cast off with Doc::CastOffDoc or Doc::CastOffDocIncrementally).
+     */
+    bool CastOffDocFrom(Page *page, bool incrementally);
+
+    /**
+     * Return true if some content still needs to be cast off (see Doc::CastOffDocIncrementally).
+     */
+    bool HasPendingPage() const { return (m_castOffPendingPage != NULL); }
+
     /**
      * Undo the cast off of the entire document.
      * The document will then contain one single page with one single system.
      */
     void UnCastOffDoc();
 
+    /**
+     * Cast off the pages again from the systems of the document, which are kept as they are.
+     * This is enough when only the vertical layout (e.g., the page height or the staff spacing) has changed.
+     * The document cannot have a pending page (see Doc::CastOffDocIncrementally).
+     */
+    void CastOffPagesDoc();
+
     /**
      * Cast off of the entire document according to the encoded data (pb and sb).
      * Does not perform any check on the presence and / or validity of such data.
      */
     void CastOffEncodingDoc();
 
+    /**
+     * Cast off of the entire document according to a previously calculated layout (e.g., from the layout cache).
+     * The layout is given as the number of systems for each page and the number of children (measures, scoreDefs,
+     * boundaries) for each system, with optional uuids for the pages and the systems.
+     * Return false and leave the document unchanged if the layout does not match the content.
+     */
+    bool CastOffLayoutDoc(const std::vector<int> &systemsPerPage, const std::vector<int> &childrenPerSystem,
+        const std::vector<std::string> &pageUuids, const std::vector<std::string> &systemUuids);
+
     /**
      * Convert the doc from score-based to page-based MEI.
      * Containers will be converted to boundaryStart / boundaryEnd.
@@ -311,6 +415,42 @@ private:
      */
     int CalcMusicFontSize();
 
+    /**
+     * Calculate the glyph metrics for the current music font size if it or the font has changed.
+     * Called from Doc::SetDrawingPage, which is never called concurrently.
+     */
+    void UpdateGlyphMetrics();
+
+    /**
+     * Return the index of the glyph in the metrics arrays, or VRV_UNSET if they do not have the glyph or were
+     * calculated for another font or font size (the glyph bounding box is then used directly).
+     */
+    int GetGlyphMetricsIdx(wchar_t code, bool graceSize) const;
+
+    /**
+     * Cast off the next chunk of the pending content.
+     * The systems of the last page are moved back to the pending page unless the cast off is complete.
+     */
+    void CastOffPendingChunk();
+
+    /**
+     * Return the longest duration of the visible content (DUR_4 if there is none).
+     */
+    int GetLongestActualDur();
+
+    /**
+     * Generate the MIDI events of the layers from first to last (excluded) of a staff into the event list.
+     * The notes are added each time their measure is played according to the timemap.
+     * Called concurrently for each staff by ExportMIDI - only the notes of the staff are changed.
+     */
+    void GenerateMIDIStaff(
+        MapOfMIDINoteTuples::iterator first, MapOfMIDINoteTuples::iterator last, int transSemi, MidiEventList *events);
+
+    /**
+     * Return true if the element referred to (e.g., by a @startid) is in one of the measures, visible or not.
+     */
+    bool IsReferenceInMeasures(const std::string &reference, const std::vector<Measure *> &measures);
+
 public:
     /**
      * A copy of the header tree stored as pugi::xml_document
@@ -394,11 +534,27 @@ private:
     int m_drawingSmuflFontSize;
     /** Lyric font size  */
     int m_drawingLyricFontSize;
+    /** The music font of the document */
+    MusicFont *m_musicFont;
     /** Current music font */
     FontInfo m_drawingSmuflFont;
     /** Current lyric font */
     FontInfo m_drawingLyricFont;
 
+    /**
+     * @name The width, height and descender of the SMuFL glyphs scaled to the music font size, for the normal and
+     * the grace size (two values for each code from SMUFL_FIRST_CODE). The staff size is applied when they are
+     * returned, which gives the same values as scaling the glyph bounding box each time.
+     * The font size and the font they were calculated with are also stored.
+     */
+    ///@{
+    std::vector<int> m_glyphWidths;
+    std::vector<int> m_glyphHeights;
+    std::vector<int> m_glyphDescenders;
+    int m_glyphMetricsFontSize;
+    MusicFont *m_glyphMetricsFont;
+    ///@}
+
     /**
      * A flag to indicate whether the currentScoreDef has been set or not.
      * If yes, SetCurrentScoreDef will not parse the document (again) unless
@@ -418,6 +574,16 @@ private:
      */
     bool m_midiExportDone;
 
+    /**
+     * The map between the score time, the performance time and the real time, built by the MIDI export.
+     */
+    Timemap m_timemap;
+
+    /**
+     * The notes of each staff/layer cached by measure by the MIDI export.
+     */
+    MapOfMeasureMIDINoteTuples m_midiCache;
+
     /** Page width (MEI scoredef@page.width) - currently not saved */
     int m_pageWidth;
     /** Page height (MEI scoredef@page.height) - currently not saved */
@@ -437,6 +603,21 @@ private:
      * A score buffer for loading or creating a scoreBased MEI.
      */
     Score *m_scoreBuffer;
+
+    /**
+     * @name Values for casting off the document incrementally
+     * The pending page is the last page of the document and holds the systems of the last incomplete page
+     * followed by the system with the content not cast off yet. It is NULL once the cast off is complete.
+     */
+    ///@{
+    Page *m_castOffPendingPage;
+    /** The number of children of the pending system to cast off with the next chunk */
+    int m_castOffChunkSize;
+    /** The current scoreDef width at the end of the previous chunk (see CastOffSystemsParams) */
+    int m_castOffScoreDefWidth;
+    /** The longest duration of the entire content used for laying out each chunk (VRV_UNSET if not cast off with it) */
+    int m_castOffLongestActualDur;
+    ///@}
 };
 
 } // namespace vrv
@@ -62,6 +62,12 @@ public:
     virtual void AddChild(Object *object);
     ///@}
 
+    /**
+     * Make the child visible and hide the other ones, as within an <app> or a <choice>.
+     * Return true if the visibility of a child changed.
+     */
+    bool SetVisibleChild(EditorialElement *child);
+
     //----------//
     // Functors //
     //----------//
@@ -79,6 +79,11 @@ public:
      */
     virtual int PrepareFloatingGrps(FunctorParams *functoParams);
 
+    /**
+     * See Object::CalcMaxMeasureDuration
+     */
+    virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+
 private:
     //
 public:
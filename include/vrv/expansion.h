@@ -40,6 +40,11 @@ public:
     // Functors //
     //----------//
 
+    /**
+     * See Object::CalcMaxMeasureDuration
+     */
+    virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+
 protected:
     //
 private:
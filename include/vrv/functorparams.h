@@ -40,6 +40,7 @@ class StaffDef;
 class Syl;
 class System;
 class SystemAligner;
+class Timemap;
 
 //----------------------------------------------------------------------------
 // FunctorParams
@@ -515,18 +516,25 @@ public:
  * member 0: std::vector<double>: a stack of maximum duration filled by the functor
  * member 1: double: the duration of the current measure
  * member 2: the current bpm
+ * member 3: Timemap*: the timemap to which the structure and the tempo changes are added
+ * member 4: std::vector<std::pair<double, double> >: the tempo changes (time and bpm) of the current measure
+ * member 5: std::vector<Measure *>: the measures for which the MIDI data has to be generated again
 **/
 
 class CalcMaxMeasureDurationParams : public FunctorParams {
 public:
-    CalcMaxMeasureDurationParams()
+    CalcMaxMeasureDurationParams(Timemap *timemap)
     {
         m_currentValue = 0.0;
         m_currentBpm = 120;
+        m_timemap = timemap;
     }
     std::vector<double> m_maxValues;
     double m_currentValue;
     int m_currentBpm;
+    Timemap *m_timemap;
+    std::vector<std::pair<double, double> > m_measureTempos;
+    std::vector<Measure *> m_modifiedMeasures;
 };
 
 //----------------------------------------------------------------------------
@@ -796,33 +804,40 @@ public:
 //----------------------------------------------------------------------------
 
 /**
- * member 0: MidiFile*: the MidiFile we are writing to
- * member 1: int*: the midi track number
- * member 2: int*: the current time in the measure (incremented by each element)
- * member 3: int*: the current total measure time (incremented by each measure
- * member 4: std::vector<double>: a stack of maximum duration filled by the functor
- * member 5: int* the semi tone transposition for the current track
- * member 6: int with the current bpm
+ * member 0: double: the current time in the measure (incremented by each element)
+ * member 1: int: the index of the current measure
+ * member 2: int with the current bpm
+ * member 3: std::map<std::pair<int, int>, double>: the current time in the measure for each staff/layer
+ * member 4: MapOfMIDINoteTuples: the notes (measure, onset, offset, pitch, note) generated for each staff/layer
+ * member 5: std::pair<int, int>: the staff/layer @n being processed
+ * member 6: ArrayOfMIDINoteTuples*: the notes of the staff/layer being processed
+ * member 7: const MapOfMeasureMIDINoteTuples*: the notes of each measure cached by the previous export
+ * member 8: MapOfMeasureMIDINoteTuples: the notes of each measure to be cached for the next export
+ * member 9: MapOfMIDINoteTuples*: the notes of the measure being processed
 **/
 
 class GenerateMIDIParams : public FunctorParams {
 public:
-    GenerateMIDIParams(MidiFile *midiFile)
+    GenerateMIDIParams(const MapOfMeasureMIDINoteTuples *cachedNotes)
     {
-        m_midiFile = midiFile;
-        m_midiTrack = 1;
         m_currentMeasureTime = 0.0;
-        m_totalTime = 0.0;
-        m_transSemi = 0;
+        m_measureIdx = 0;
         m_currentBpm = 120;
+        m_currentLayerN = std::make_pair(VRV_UNSET, VRV_UNSET);
+        m_currentLayerNotes = NULL;
+        m_cachedNotes = cachedNotes;
+        m_currentMeasureNotes = NULL;
     }
-    MidiFile *m_midiFile;
-    int m_midiTrack;
     double m_currentMeasureTime;
-    double m_totalTime;
-    std::vector<double> m_maxValues;
-    int m_transSemi;
+    int m_measureIdx;
     int m_currentBpm;
+    std::map<std::pair<int, int>, double> m_layerMeasureTimes;
+    MapOfMIDINoteTuples m_layerNotes;
+    std::pair<int, int> m_currentLayerN;
+    ArrayOfMIDINoteTuples *m_currentLayerNotes;
+    const MapOfMeasureMIDINoteTuples *m_cachedNotes;
+    MapOfMeasureMIDINoteTuples m_measureNotes;
+    MapOfMIDINoteTuples *m_currentMeasureNotes;
 };
 
 //----------------------------------------------------------------------------
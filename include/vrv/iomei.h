@@ -330,6 +330,158 @@ private:
     std::list<pugi::xml_node> m_nodeStack;
 };
 
+//----------------------------------------------------------------------------
+// MeiMdivIndex
+//----------------------------------------------------------------------------
+
+/**
+ * This class indexes the <mdiv> of MEI data with a structural scan of the text, without parsing it.
+ * The data of one <mdiv> can then be extracted with the header and the elements around the <body> only,
+ * so that the other movements are never parsed when it is loaded.
+ */
+class MeiMdivIndex {
+public:
+    // constructors and destructors
+    MeiMdivIndex();
+    virtual ~MeiMdivIndex();
+
+    /**
+     * Clear the index.
+     */
+    void Reset();
+
+    /**
+     * Index the <mdiv> within the first <body> of the data.
+     * Return false if the data has no <body> or if its tags are not balanced.
+     */
+    bool Scan(const std::string &mei);
+
+    /**
+     * Return the number of <mdiv> in the index, including the nested ones.
+     */
+    int GetMdivCount() const { return (int)m_mdivs.size(); }
+
+    /**
+     * @name Getters for the <mdiv> idx, in document order.
+     * The level is 0 for the <mdiv> children of the <body>, and the parent is the index of the containing
+     * <mdiv> (-1 for level 0). The begin and end are the byte offsets of its start tag and after its end tag.
+     */
+    ///@{
+    const std::string &GetId(int idx) const { return m_mdivs.at(idx).m_id; }
+    const std::string &GetN(int idx) const { return m_mdivs.at(idx).m_n; }
+    const std::string &GetLabel(int idx) const { return m_mdivs.at(idx).m_label; }
+    int GetLevel(int idx) const { return m_mdivs.at(idx).m_level; }
+    int GetParent(int idx) const { return m_mdivs.at(idx).m_parent; }
+    size_t GetBegin(int idx) const { return m_mdivs.at(idx).m_begin; }
+    size_t GetEnd(int idx) const { return m_mdivs.at(idx).m_end; }
+    ///@}
+
+    /**
+     * Return the data with the <mdiv> idx (within the <mdiv> containing it, if any) as the only content
+     * of the <body>. The data must be the one that was scanned.
+     */
+    std::string Extract(const std::string &mei, int idx) const;
+
+private:
+    /**
+     * Read the attributes of the start tag between begin and end into the <mdiv> entry.
+     */
+    void ReadAttributes(const std::string &mei, size_t begin, size_t end, int idx);
+
+public:
+    //
+private:
+    /**
+     * An <mdiv> in the index.
+     * The content begin is the offset after its start tag.
+     */
+    class MdivEntry {
+    public:
+        std::string m_id;
+        std::string m_n;
+        std::string m_label;
+        int m_level;
+        int m_parent;
+        size_t m_begin;
+        size_t m_contentBegin;
+        size_t m_end;
+    };
+
+    std::vector<MdivEntry> m_mdivs;
+
+    /**
+     * @name The offsets after the <body> start tag and of the <body> end tag
+     */
+    ///@{
+    size_t m_bodyContentBegin;
+    size_t m_bodyEnd;
+    ///@}
+};
+
+//----------------------------------------------------------------------------
+// MeiSelectionQuery
+//----------------------------------------------------------------------------
+
+/**
+ * This class stores an XPath query selecting a child of <app> or <choice>, compiled once when it is set.
+ * The queries of the form ./name or ./name[contains(@source,'value')] are matched directly against the
+ * children without evaluating the XPath expression.
+ */
+class MeiSelectionQuery {
+public:
+    // constructors and destructors
+    MeiSelectionQuery(const std::string &query);
+    virtual ~MeiSelectionQuery();
+
+    /**
+     * Return false if the query could not be compiled.
+     */
+    bool IsValid() const { return (m_isSimple || m_xpathQuery); }
+
+    /**
+     * Return true if the query is matched against the children directly.
+     */
+    bool IsSimple() const { return m_isSimple; }
+
+    /**
+     * Return true if the child matches a simple query.
+     */
+    bool MatchesChild(pugi::xml_node child) const;
+
+    /**
+     * Evaluate the compiled XPath query for the parent node.
+     * Return the node selected or an empty node.
+     */
+    pugi::xml_node Evaluate(pugi::xml_node parentNode) const;
+
+private:
+    /**
+     * Parse the query as ./name or ./name[contains(@source,'value')].
+     * Return false if the query has another form.
+     */
+    bool ParseSimpleQuery(const std::string &query);
+
+    // Not copyable since it owns the compiled query
+    MeiSelectionQuery(const MeiSelectionQuery &);
+    MeiSelectionQuery &operator=(const MeiSelectionQuery &);
+
+public:
+    //
+private:
+    /** The compiled XPath query, NULL for simple queries or if it could not be compiled */
+    pugi::xpath_query *m_xpathQuery;
+
+    /**
+     * @name The name of the child and the value contained in its @source for simple queries
+     */
+    ///@{
+    bool m_isSimple;
+    bool m_hasSource;
+    std::string m_name;
+    std::string m_source;
+    ///@}
+};
+
 //----------------------------------------------------------------------------
 // MeiInput
 //----------------------------------------------------------------------------
@@ -353,14 +505,15 @@ public:
      * By default, the first <lem> or <rdg> is loaded.
      * If one (or more) query is provided, the element matching the specified xPath
      * query will be selected (if any, otherwise the first one will be used).
+     * The queries are compiled once and the invalid ones are ignored.
      */
-    virtual void SetAppXPathQueries(std::vector<std::string> &xPathQueries) { m_appXPathQueries = xPathQueries; }
+    virtual void SetAppXPathQueries(std::vector<std::string> &xPathQueries);
 
     /**
      * Set the xPath queries for selecting <choice> children.
      * Works similarly as SetAppXPathQueries. By default, the first child is made visible
      */
-    virtual void SetChoiceXPathQueries(std::vector<std::string> &xPathQueries) { m_choiceXPathQueries = xPathQueries; }
+    virtual void SetChoiceXPathQueries(std::vector<std::string> &xPathQueries);
 
     /**
      * Set the XPath query for selecting a specific <mdiv>
@@ -542,6 +695,17 @@ private:
      */
     bool IsEditorialElementName(std::string elementName);
 
+    /**
+     * Return the child of the parent node selected by the first query matching it, or an empty node.
+     * The children are looked at once for all the simple queries and only the other ones are evaluated as XPath.
+     */
+    pugi::xml_node SelectChild(const std::vector<MeiSelectionQuery *> &queries, pugi::xml_node parentNode);
+
+    /**
+     * Compile the queries, ignoring the invalid ones, and replace the previous ones.
+     */
+    void SetSelectionQueries(std::vector<MeiSelectionQuery *> &queries, const std::vector<std::string> &xPathQueries);
+
     /**
      * Read score-based MEI.
      * The data is read into an object, which is then converted to page-based MEI.
@@ -575,14 +739,14 @@ private:
     MEIVersion m_version;
 
     /**
-     * A vector for storing xpath queries for selecting <app> children
+     * A vector for storing the compiled xpath queries for selecting <app> children
      */
-    std::vector<std::string> m_appXPathQueries;
+    std::vector<MeiSelectionQuery *> m_appXPathQueries;
 
     /**
-     * A vector the storing xpath queries for selecting <choice> children
+     * A vector the storing the compiled xpath queries for selecting <choice> children
      */
-    std::vector<std::string> m_choiceXPathQueries;
+    std::vector<MeiSelectionQuery *> m_choiceXPathQueries;
 
     /**
      * A string for storing the xpath query for selecting a <mdiv>
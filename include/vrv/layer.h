@@ -134,6 +134,11 @@ public:
      */
     virtual int UnsetCurrentScoreDef(FunctorParams *functorParams);
 
+    /**
+     * See Object::ResetHorizontalAlignment
+     */
+    virtual int ResetHorizontalAlignment(FunctorParams *functorParams);
+
     /**
      * See Object::AlignHorizontally
      */
@@ -168,6 +173,14 @@ public:
      */
     virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
 
+    /**
+     * @name See Object::GenerateMIDI
+     */
+    ///@{
+    virtual int GenerateMIDI(FunctorParams *functorParams);
+    virtual int GenerateMIDIEnd(FunctorParams *functorParams);
+    ///@}
+
 private:
     //
 public:
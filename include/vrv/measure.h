@@ -310,9 +310,12 @@ public:
     ///@}
 
     /**
-     * See Object::CalcMaxMeasureDuration
+     * @name See Object::CalcMaxMeasureDuration
      */
+    ///@{
     virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+    virtual int CalcMaxMeasureDurationEnd(FunctorParams *functorParams);
+    ///@}
 
     /**
      * See Object::PrepareTimestamps
@@ -336,6 +339,13 @@ public:
 
     TimestampAligner m_timestampAligner;
 
+    /**
+     * Flag indicating if the MIDI data cached for the measure by the previous export can be used.
+     * It is reset by CalcMaxMeasureDuration when the measure has been modified (see Object::Modify) and set again by
+     * Doc::ExportMIDI once the MIDI data of the measure has been generated.
+     */
+    bool m_midiCacheValid;
+
 protected:
     /**
      * The X relative position of the measure.
@@ -372,6 +382,14 @@ private:
      * A flag indicating if the measure has AlignmentReference with multiple layers
      */
     bool m_hasAlignmentRefWithMultipleLayers;
+
+    /**
+     * @name The duration and the tempo changes (time and bpm) of the measure cached by the previous MIDI export
+     */
+    ///@{
+    double m_midiCachedDuration;
+    std::vector<std::pair<double, double> > m_midiCachedTempos;
+    ///@}
 };
 
 } // namespace vrv
@@ -8,6 +8,7 @@
 #ifndef __VRV_OBJECT_H__
 #define __VRV_OBJECT_H__
 
+#include <atomic>
 #include <cstdlib>
 #include <ctime>
 #include <iterator>
@@ -18,6 +19,7 @@
 
 #include "attclasses.h"
 #include "boundingbox.h"
+#include "profiler.h"
 #include "vrvdef.h"
 
 namespace vrv {
@@ -86,6 +88,28 @@ public:
     virtual std::string GetClassName() const { return "[MISSING]"; }
     ///@}
 
+    /**
+     * @name Allocation of the objects
+     * The memory of the objects deleted is kept in free lists by size, shared by all the threads, and used again for
+     * the objects created afterwards. Loading documents one after the other reuses the same memory instead of
+     * fragmenting the heap. The memory kept is capped for all the threads together and released when the program ends.
+     */
+    ///@{
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+    ///@}
+
+    /**
+     * @name Return the number of objects created with memory from the free lists and their size in bytes.
+     * These allocations do not go through the global operator new. The count is the one of all the threads.
+     * They are counted only when compiled with USE_ALLOCATION_COUNTING (the ALLOCATION_COUNTING option of CMake) and
+     * 0 is returned otherwise.
+     */
+    ///@{
+    static unsigned long long GetReusedAllocations();
+    static unsigned long long GetReusedBytes();
+    ///@}
+
     /**
      * Make an object a reference object that do not own children.
      * This cannot be un-done and has to be set before any child is added.
@@ -908,7 +932,10 @@ public:
     /**
      * Calculate the maximum duration of each measure.
      */
+    ///@{
     virtual int CalcMaxMeasureDuration(FunctorParams *) { return FUNCTOR_CONTINUE; }
+    virtual int CalcMaxMeasureDurationEnd(FunctorParams *) { return FUNCTOR_CONTINUE; }
+    ///@}
 
     ///@}
 
@@ -1005,8 +1032,9 @@ private:
 
     /**
      * A static counter for uuid generation.
+     * Atomic because objects (e.g., the StaffAlignment ones) can be created concurrently during the layout.
      */
-    static unsigned long s_objectCounter;
+    static std::atomic<unsigned long> s_objectCounter;
 };
 
 //----------------------------------------------------------------------------
@@ -1125,13 +1153,19 @@ private:
 public:
     // constructor - takes pointer to an object and pointer to a member and stores
     // them in two private variables
+    // The name is the one of the member and is used only for profiling
     Functor();
-    Functor(int (Object::*_obj_fpt)(FunctorParams *));
+    Functor(int (Object::*_obj_fpt)(FunctorParams *), const char *name = "");
     virtual ~Functor(){};
 
     // override function "Call"
     virtual void Call(Object *ptr, FunctorParams *functorParams);
 
+    /**
+     * Return the name given to the functor.
+     */
+    const char *GetName() const { return m_name; }
+
 private:
     //
 public:
@@ -1148,7 +1182,16 @@ public:
      */
     bool m_visibleOnly;
 
+#ifdef USE_PROFILING
+    /**
+     * What the functor does during the current pass (see Object::Process).
+     */
+    FunctorProfile m_profile;
+#endif
+
 private:
+    /** The name of the functor */
+    const char *m_name;
 };
 
 //----------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 namespace vrv {
 
 class DeviceContext;
+class Doc;
 class PrepareProcessingListsParams;
 class Staff;
 class System;
@@ -78,6 +79,11 @@ public:
      */
     void LayOut(bool force = false);
 
+    /**
+     * Mark the layout of the page to be done again the next time the page is drawn.
+     */
+    void ResetLayout() { m_layoutDone = false; }
+
     /**
      * Do the layout for a transcription page (with layout information).
      * This only calculates positioning or layer element parts using provided layout of parents.
@@ -85,9 +91,10 @@ public:
     void LayOutTranscription(bool force = false);
 
     /**
-     * Lay out the content of the page (measures and their content) horizontally
+     * Lay out the content of the page (measures and their content) horizontally.
+     * The duration-based spacing uses the longest duration of the page unless another one is given.
      */
-    void LayOutHorizontally();
+    void LayOutHorizontally(int longestActualDur = VRV_UNSET);
 
     /**
      * Justifiy the content of the page (measures and their content) horizontally
@@ -96,6 +103,7 @@ public:
 
     /**
      * Lay out the content of the page (system/staves) vertically.
+     * The systems are laid out concurrently (see ProcessConcurrently) and then aligned on the page.
      */
     void LayOutVertically();
 
@@ -139,6 +147,15 @@ public:
     virtual int ApplyPPUFactor(FunctorParams *);
 
 private:
+    /**
+     * @name Lay out the content of one system vertically, before and after its bounding boxes are filled.
+     * They modify only the system and its content, which makes them safe to call concurrently for different systems.
+     */
+    ///@{
+    void AlignSystemVertically(System *system, Doc *doc);
+    void AdjustSystemVertically(System *system, Doc *doc);
+    ///@}
+
     /**
      * Adjust the horizontal postition of the syl processing verse by verse
      */
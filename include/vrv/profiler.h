@@ -0,0 +1,153 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        profiler.h
+// Author:      Verovio contributors
+// Created:     2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_PROFILER_H__
+#define __VRV_PROFILER_H__
+
+#include <string>
+
+#ifdef USE_PROFILING
+#include <chrono>
+#include <map>
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "vrvdef.h"
+
+namespace vrv {
+
+/**
+ * The profiling is compiled only with USE_PROFILING (the PROFILING option of CMake).
+ * PROFILE_STAGE records the time of the enclosing scope as a stage with the given name.
+ * The macro is empty otherwise and Profiler returns an empty profile.
+ */
+#ifdef USE_PROFILING
+#define PROFILE_STAGE(name) ProfileScope profileScope(name)
+#else
+#define PROFILE_STAGE(name)
+#endif
+
+/**
+ * The maximum number of events kept for the trace - the stages and the functor passes are still summed afterwards.
+ */
+#define PROFILER_MAX_TRACE_EVENTS 200000
+
+#ifdef USE_PROFILING
+
+typedef std::chrono::steady_clock::time_point ProfileTime;
+
+//----------------------------------------------------------------------------
+// FunctorProfile
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds what a Functor does during a pass, i.e., a call to Object::Process not nested in another call
+ * with the same functor. It is added to the Profiler and reset at the end of each pass.
+ */
+class FunctorProfile {
+public:
+    /** @name Constructors and destructor */
+    ///@{
+    FunctorProfile();
+    virtual ~FunctorProfile() {}
+    ///@}
+
+    /**
+     * Clear what was recorded for the pass.
+     */
+    void Reset();
+
+    /**
+     * Add a call of the functor on an object of a class and the time spent in it.
+     */
+    void AddCall(ClassId classId, const std::string &className, double time);
+
+public:
+    /** The depth of Object::Process calls and of calls to the functor, for detecting the outermost ones */
+    int m_processDepth;
+    int m_callDepth;
+    /** The beginning of the pass and of the outermost call */
+    ProfileTime m_passStart;
+    ProfileTime m_callStart;
+    /** The objects reached by the pass, including the ones reached after the functor stopped */
+    unsigned long long m_visited;
+    /** The objects the functor was called on */
+    unsigned long long m_actedOn;
+    /** The class name, the number of calls and the time spent in them (in ms) for each class */
+    std::map<ClassId, std::pair<std::string, std::pair<unsigned long long, double> > > m_classes;
+};
+
+//----------------------------------------------------------------------------
+// ProfileScope
+//----------------------------------------------------------------------------
+
+/**
+ * This class adds the time from its creation to its destruction as a stage to the Profiler.
+ * It should be used through the PROFILE_STAGE macro.
+ */
+class ProfileScope {
+public:
+    ProfileScope(const char *name);
+    virtual ~ProfileScope();
+
+private:
+    const char *m_name;
+    ProfileTime m_start;
+};
+
+#endif
+
+//----------------------------------------------------------------------------
+// Profiler
+//----------------------------------------------------------------------------
+
+/**
+ * This static class collects the time spent in the stages of the loading, the layout and the rendering and what each
+ * functor does (time, objects visited and acted on, time per class).
+ * The profile is global to the process and is collected from all the threads.
+ */
+class Profiler {
+public:
+    /**
+     * Return true if the profiling is compiled in.
+     */
+    static bool IsEnabled();
+
+    /**
+     * Clear the profile collected so far.
+     */
+    static void Reset();
+
+    /**
+     * Return the summary of the profile as JSON, with the stages and the functors sorted by name.
+     * The times are given in milliseconds.
+     */
+    static std::string GetSummary();
+
+    /**
+     * Return the stages and the functor passes as a Chrome trace-event file (JSON).
+     * It can be opened with chrome://tracing or similar viewers.
+     */
+    static std::string GetTrace();
+
+#ifdef USE_PROFILING
+    /**
+     * @name Methods for adding a stage and the pass of a functor.
+     * The pass of the end functor (if any) is added with the pass of the functor.
+     */
+    ///@{
+    static void AddStage(const char *name, const ProfileTime &start, const ProfileTime &end);
+    static void AddFunctorPass(
+        const char *name, const FunctorProfile &profile, const ProfileTime &start, const ProfileTime &end);
+    ///@}
+#endif
+};
+
+} // namespace vrv
+
+#endif // __VRV_PROFILER_H__
@@ -192,6 +192,11 @@ public:
      */
     virtual int CastOffEncoding(FunctorParams *functorParams);
 
+    /**
+     * See Object::CalcMaxMeasureDuration
+     */
+    virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+
 protected:
     /**
      * Filter the list for a specific class.
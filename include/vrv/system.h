@@ -216,6 +216,11 @@ public:
     int m_drawingTotalWidth;
     int m_drawingJustifiableWidth;
     ///@}
+    /**
+     * The current scoreDef width when the system was cast off (see CastOffSystemsParams).
+     * It is used for casting off the document again from the system (see Doc::CastOffDocFrom).
+     */
+    int m_castOffScoreDefWidth;
 
 protected:
     /**
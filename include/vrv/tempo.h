@@ -61,6 +61,11 @@ public:
     // Functors //
     //----------//
 
+    /**
+     * See Object::CalcMaxMeasureDuration
+     */
+    virtual int CalcMaxMeasureDuration(FunctorParams *functorParams);
+
 private:
     //
 public:
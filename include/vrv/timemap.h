@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        timemap.h
+// Author:      Verovio contributors
+// Created:     2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef __VRV_TIMEMAP_H__
+#define __VRV_TIMEMAP_H__
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+#include "atts_midi.h"
+
+namespace vrv {
+
+/**
+ * The number of MIDI ticks per quarter note used for the score and performance times.
+ * This is also the default time base of a MidiFile.
+ */
+#define TIMEMAP_TICKS_PER_QUARTER 120
+
+/**
+ * The tempo used when none is given in the document, which is also the default tempo of MIDI files.
+ */
+#define TIMEMAP_DEFAULT_BPM 120
+
+//----------------------------------------------------------------------------
+// Timemap
+//----------------------------------------------------------------------------
+
+/**
+ * This class maps the time in the score to the time in the performance and to the real time.
+ * The score time is given in ticks with the measures in document order. This is the time of the notes.
+ * The performance time is given in ticks with the measures in the order given by the expansions, meaning
+ * that a measure can be played more than once or not at all.
+ * The real time is given in milliseconds once the tempo changes have been applied to the performance time.
+ * The structure of the document and the tempo changes are added in document order by the CalcMaxMeasureDuration
+ * functor and the map is then built once by Doc::ExportMIDI. All lookups are then O(log n).
+ */
+class Timemap {
+public:
+    /** @name Constructors and destructor */
+    ///@{
+    Timemap();
+    virtual ~Timemap();
+    ///@}
+
+    /**
+     * Clear the structure, the tempo changes and the map.
+     */
+    void Reset();
+
+    /**
+     * @name Methods for adding the structure of the document and the tempo changes, in document order.
+     * The measure index of a tempo change is the index of the measure in document order.
+     */
+    ///@{
+    void AddMeasure(const std::string &uuid);
+    void StartSection(const std::string &uuid);
+    void EndSection();
+    void AddExpansion(const std::string &plist);
+    void AddTempo(int measureIdx, double time, double bpm);
+    ///@}
+
+    /**
+     * Unroll the performance order and calculate the real time of the tempo changes.
+     * The duration of each measure (in document order) and the tempo at the beginning have to be given.
+     */
+    void Build(const std::vector<double> &measureDurations, double bpm);
+
+    /**
+     * Return the score time of the beginning of a measure (in document order).
+     */
+    double GetScoreTime(int measureIdx) const { return m_scoreTimes.at(measureIdx); }
+
+    /**
+     * Return the performance times of the beginning of a measure, one for each time it is played.
+     */
+    const std::vector<double> &GetPerformanceTimes(int measureIdx) const { return m_performanceTimes.at(measureIdx); }
+
+    /**
+     * @name Getters for the tempo changes in performance time, starting with the initial tempo
+     */
+    ///@{
+    int GetTempoCount() const { return (int)m_tempoTimes.size(); }
+    double GetTempoTime(int idx) const { return m_tempoTimes.at(idx); }
+    double GetTempoBpm(int idx) const { return m_tempoBpms.at(idx); }
+    ///@}
+
+    /**
+     * Return the real time (in milliseconds) of a score time the first time it is played.
+     * Return 0.0 if the score time is never played.
+     */
+    double GetRealTimeForScoreTime(double scoreTime) const;
+
+    /**
+     * Return the score time played at a real time (in milliseconds).
+     */
+    double GetScoreTimeForRealTime(double realTime) const;
+
+    /**
+     * Return the tempo in bpm given by @midi.bpm or @midi.mspb, or 0.0 if none is given.
+     */
+    static double GetMidiTempoBpm(const AttMiditempo *midiTempo);
+
+private:
+    /**
+     * Add the measures of the section between the structure items begin and end in their performance order.
+     */
+    void UnrollSection(int begin, int end, std::vector<int> &order) const;
+
+    /**
+     * Add a tempo change at a performance time - changes at the same time replace the previous one.
+     */
+    void AddTempoChange(double performanceTime, double bpm);
+
+    /**
+     * Return the real time of a performance time.
+     */
+    double GetRealTimeForPerformanceTime(double performanceTime) const;
+
+public:
+    //
+private:
+    /**
+     * The types of the items of the structure.
+     */
+    enum { TIMEMAP_MEASURE = 0, TIMEMAP_SECTION_START, TIMEMAP_SECTION_END, TIMEMAP_EXPANSION };
+
+    /**
+     * The structure of the document in document order.
+     * Each item has its type, a measure index (for measures) or the index of the section end (for section starts)
+     * and a uuid (for measures and section starts) or a plist (for expansions).
+     */
+    std::vector<std::tuple<int, int, std::string> > m_structure;
+    /** The section starts waiting for their end */
+    std::vector<int> m_openSections;
+    /** The number of measures added */
+    int m_measureCount;
+
+    /**
+     * The tempo changes as measure index, time in the measure and bpm, in document order
+     */
+    std::vector<std::tuple<int, double, double> > m_tempos;
+
+    /**
+     * @name The map from score time to performance time
+     */
+    ///@{
+    std::vector<double> m_scoreTimes;
+    std::vector<std::vector<double> > m_performanceTimes;
+    std::vector<int> m_performedMeasures;
+    std::vector<double> m_performedTimes;
+    ///@}
+
+    /**
+     * @name The map from performance time to real time
+     */
+    ///@{
+    std::vector<double> m_tempoTimes;
+    std::vector<double> m_tempoRealTimes;
+    std::vector<double> m_tempoBpms;
+    ///@}
+};
+
+} // namespace vrv
+
+#endif // __VRV_TIMEMAP_H__
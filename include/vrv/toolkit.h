@@ -8,11 +8,15 @@
 #ifndef __VRV_TOOLKIT_H__
 #define __VRV_TOOLKIT_H__
 
+#include <functional>
+#include <list>
 #include <string>
+#include <tuple>
 
 //----------------------------------------------------------------------------
 
 #include "doc.h"
+#include "iomei.h"
 #include "view.h"
 
 //----------------------------------------------------------------------------
@@ -28,6 +32,32 @@ namespace vrv {
 
 enum FileFormat { UNKNOWN = 0, AUTO, MEI, HUMDRUM, PAE, DARMS, MUSICXML, MUSICXMLHUM, MIDI };
 
+/**
+ * The stage of the layout invalidated by a change of the options, from the least to the most work needed.
+ * OPTIONS_NONE: only the rendering is changed (scale, showBoundingBoxes, adjustPageHeight)
+ * OPTIONS_VERTICAL: the pages are cast off and laid out vertically again (pageHeight, spacingStaff, spacingSystem,
+ * noJustification)
+ * OPTIONS_CASTOFF: the systems are cast off again (pageWidth, border, spacingLinear, spacingNonLinear,
+ * evenNoteSpacing, font, incrementalLayout)
+ * The other options (e.g., inputFormat, the xPath queries, noLayout or ignoreLayout) are used only when loading data.
+ */
+enum OptionsStage { OPTIONS_NONE = 0, OPTIONS_VERTICAL, OPTIONS_CASTOFF };
+
+/**
+ * The stages of the toolkit reported to its stage hook (see Toolkit::SetStageHook).
+ * TOOLKIT_STAGE_PARSE: the import of the data when loading it
+ * TOOLKIT_STAGE_PREPARE_DRAWING: the preparation of the document for drawing when loading it
+ * TOOLKIT_STAGE_CASTOFF: the cast off of the document, when loading it, when the layout is done again or when some
+ * pending pages are cast off
+ * TOOLKIT_STAGE_LAYOUT: the layout of a page when rendering it, which is done only the first time it is rendered
+ */
+enum ToolkitStage {
+    TOOLKIT_STAGE_PARSE = 0,
+    TOOLKIT_STAGE_PREPARE_DRAWING,
+    TOOLKIT_STAGE_CASTOFF,
+    TOOLKIT_STAGE_LAYOUT
+};
+
 //----------------------------------------------------------------------------
 // Toolkit
 //----------------------------------------------------------------------------
@@ -59,6 +89,24 @@ public:
      */
     bool LoadData(const std::string &data);
 
+    /**
+     * @name Index the <mdiv> of MEI data and load one of them
+     * IndexMdivs scans the data without parsing it and keeps it. LoadMdiv then loads the <mdiv> idx (in document
+     * order, see GetMdivIndex) with only the header and the elements around the <body>, so that the other movements
+     * are never parsed. The xPath query for selecting a <mdiv> is not used.
+     */
+    ///@{
+    bool IndexMdivs(const std::string &data);
+    bool LoadMdiv(int idx);
+    ///@}
+
+    /**
+     * Return the index of the <mdiv> as a JSON array with the n, label, xml:id, level, parent, begin and end (byte
+     * offsets) of each of them.
+     * Only available for Emscripten-based and Python compiles
+     **/
+    std::string GetMdivIndex();
+
     /**
      * Save an MEI file.
      */
@@ -76,6 +124,25 @@ public:
      **/
     bool Edit(const std::string &json_editorAction);
 
+    /**
+     * Select the readings of the <app> and the children of the <choice> to be displayed without loading the data
+     * again. All of them are kept in the document and only their visibility changes.
+     * The <lem> or <rdg> with appSource in its @source is selected in each <app> (or the <lem> or the first child if
+     * none has it), the first child with one of the choiceChildren names (e.g., "corr") in each <choice> (or the first
+     * child) and the children given by their ids in their parent. Empty values leave the current selection.
+     * The affected measures are prepared again (or the entire document if something is prepared across them) and the
+     * document is cast off again from the first page changed, keeping the encoded breaks if they are used.
+     * The <app> and <choice> containing measures cannot be changed.
+     */
+    bool SelectReadings(const std::string &appSource, const std::vector<std::string> &choiceChildren,
+        const std::vector<std::string> &ids);
+
+    /**
+     * Select the readings with a JSON string ({"appSource": "", "choiceChildren": [], "ids": []}).
+     * Only available for Emscripten-based and Python compiles
+     **/
+    bool SelectReadings(const std::string &json_selection);
+
     /**
      * Concatenates the vrv::logBuffer into a string an returns it.
      * This is used only for Emscripten-based compilation.
@@ -95,9 +162,31 @@ public:
      */
     void ResetLogBuffer();
 
+    /**
+     * @name Get and reset the profile of the stages and of the functors as JSON
+     * The profile is collected only when compiled with USE_PROFILING and is global to all toolkits.
+     * It has the calls and the time (in ms) of each stage, and the passes, the time, the objects visited and acted on,
+     * and the time per class of each functor (see Profiler).
+     */
+    ///@{
+    std::string GetProfile();
+    void ResetProfile();
+    ///@}
+
+    /**
+     * Set a function called at the beginning (end is false) and at the end (end is true) of each stage of the toolkit,
+     * e.g., for timing them without the profiling being compiled in. The page index is the one of the page laid out,
+     * and -1 for the other stages. The function is called in the thread using the toolkit.
+     */
+    void SetStageHook(const std::function<void(ToolkitStage stage, int pageIdx, bool end)> &stageHook)
+    {
+        m_stageHook = stageHook;
+    }
+
     /**
      * Render the page in SVG and returns it as a string.
      * Page number is 1-based
+     * The SVG is taken from the cache when the page was already rendered with the same options (see SetSvgCacheSize)
      */
     std::string RenderToSvg(int pageNo = 1, bool xml_declaration = false);
 
@@ -115,11 +204,36 @@ public:
 
     /**
      * Creates a midi file, opens it, and returns it (base64 encoded).
+     * After an edit, only the measures modified since the previous call are processed again.
      */
     std::string RenderToMidi();
 
+    /**
+     * Creates a midi file and writes it (binary) to the output stream.
+     */
+    bool RenderToMidi(std::ostream &output);
+
+    /**
+     * Creates a midi file and keeps it (binary) in a buffer owned by the toolkit.
+     * The buffer is returned by GetBinaryBuffer() and is valid until the next call.
+     * Returns the size of the buffer in bytes.
+     */
+    int RenderToMidiBuffer();
+
+    /**
+     * Return the binary buffer filled by RenderToMidiBuffer().
+     * Its size is given by the size of the string and the content is not null-terminated text.
+     */
+    const std::string &GetBinaryBuffer() { return m_binaryBuffer; }
+
+    /**
+     * @name Get and set the Humdrum data of the toolkit.
+     * The data loaded is kept once its filters have been applied. When set directly, the filters are applied.
+     */
+    ///@{
     const char *GetHumdrumBuffer();
     void SetHumdrumBuffer(const char *contents);
+    ///@}
 
     bool GetHumdrumFile(const std::string &filename);
     void GetHumdrum(std::ostream &output);
@@ -127,6 +241,8 @@ public:
 
     /**
      * Returns array of IDs of elements being currently played.
+     * The time is the real time (in milliseconds) taking into account the tempo changes and the expansions.
+     * RenderToMidi() must be called prior to using this method.
      */
     std::string GetElementsAtTime(int millisec);
 
@@ -145,9 +261,18 @@ public:
      * Redo the layout of the loaded data.
      * This can be called once the rendering option were changed,
      * For example with a new page (sceen) height or a new zoom level.
+     * Only the stage invalidated by the options changed since the last layout is redone (see OptionsStage), and
+     * everything if none was changed (e.g., after editing).
+     * Changed options are also applied automatically when rendering or looking for pages, but without casting off
+     * again a document laid out according to its encoded breaks.
      */
     void RedoLayout();
 
+    /**
+     * Return the stage of the layout invalidated by the options changed since the data was loaded or laid out.
+     */
+    OptionsStage GetInvalidatedStage();
+
     /**
      * Redo the layout of the pitch postitions of the current drawing page.
      * Only the note vertical positions are recalculated with this method.
@@ -163,7 +288,7 @@ public:
     int GetPageWithElement(const std::string &xmlId);
 
     /**
-     * Return the time at which the element is the ID (xml:id) is played.
+     * Return the time (in milliseconds) at which the element is the ID (xml:id) is played for the first time.
      * RenderToMidi() must be called prior to using this method.
      * Returns 0 if no element is found.
      */
@@ -172,11 +297,16 @@ public:
     /**
     * @name Set and get a std::string into a char * buffer.
     * This is used for returning a string buffer to emscripten.
-    * The buffer is freed when reset or in MusController destructor.
+    * The buffer is owned by the toolkit and is valid until the next call to SetCString or ReleaseCString.
+    * A temporary string is moved into the buffer, other strings are copied into the storage already allocated.
+    * The length (in bytes) allows the buffer to be decoded directly from the heap.
     */
     ///@{
     void SetCString(const std::string &data);
+    void SetCString(std::string &&data);
     const char *GetCString();
+    int GetCStringLength() const { return (int)m_cString.size(); }
+    void ReleaseCString();
     ///@}
 
     /**
@@ -263,6 +393,15 @@ public:
     int GetIgnoreLayout() { return m_ignoreLayout; }
     ///@}
 
+    /**
+     * @name Cast off the pages incrementally when they are requested
+     * The page count is then an estimate until the last page has been cast off
+     */
+    ///@{
+    void SetIncrementalLayout(bool l) { m_incrementalLayout = l; }
+    int GetIncrementalLayout() { return m_incrementalLayout; }
+    ///@}
+
     /**
      * @name Crop the page height to the height of the content
      */
@@ -279,6 +418,21 @@ public:
     int GetEvenNoteSpacing() { return m_evenNoteSpacing; }
     ///@}
 
+    /**
+     * @name Set the directory of the cache of the layouts calculated when loading data
+     * The page and system breaks are stored in a file named after a hash of the data, the options used for loading it
+     * and the layout options (page size, border, spacing and font). When the same data is loaded again with the
+     * same options, the breaks are read from the cache instead of being calculated. The directory has to exist.
+     * Only the breaks are stored: the cache is looked up after the data has been parsed and prepared for drawing, and
+     * the pages are still laid out when rendered. It saves the cast off only. It is not used with the incremental
+     * layout, without layout or when the encoded breaks are used.
+     * The cache is disabled with an empty directory (default).
+     */
+    ///@{
+    void SetLayoutCacheDir(const std::string &dir) { m_layoutCacheDir = dir; }
+    std::string GetLayoutCacheDir() { return m_layoutCacheDir; }
+    ///@}
+
     /**
      * @name Do not justify the system (for debugging purposes)
      */
@@ -287,6 +441,16 @@ public:
     int GetNoJustification() { return m_noJustification; }
     ///@}
 
+    /**
+     * @name Set the maximum size (in MB) of the cache of the pages rendered in SVG
+     * The least recently rendered pages are removed first. The cache is disabled with 0 (default).
+     * It is cleared when the data is loaded, the layout is redone or the document is edited.
+     */
+    ///@{
+    void SetSvgCacheSize(int size);
+    int GetSvgCacheSize() { return m_svgCacheSize; }
+    ///@}
+
     /**
      * @name Do not justify the system (for debugging purposes)
      */
@@ -356,6 +520,7 @@ public:
 
     /**
      * @name Set a specific font
+     * The font is changed only for the document of this toolkit.
      */
     ///@{
     bool SetFont(std::string const &font);
@@ -364,6 +529,7 @@ public:
     /**
      * @name Get the pages for a loaded file
      * The SetFormat with FileFormat does not perform any validation
+     * With incremental layout, the page count is estimated until all the pages have been cast off
      */
     ///@{
     int GetPageCount();
@@ -382,6 +548,50 @@ private:
     bool IsUTF16(const std::string &filename);
     bool LoadUTF16File(const std::string &filename);
 
+    /**
+     * Fill the midi file with the content of the document.
+     */
+    void GenerateMidiFile(MidiFile *midiFile);
+
+    /**
+     * Redo the layout of the loaded data from the given stage and store the options it was done with.
+     * Does nothing with OPTIONS_NONE.
+     * With keepEncodedBreaks, which is used when the changed options are applied automatically, a document cast off
+     * according to its encoded breaks is not cast off again and its pages are only laid out with the new options.
+     */
+    void UpdateLayout(OptionsStage stage, bool keepEncodedBreaks = false);
+
+    /**
+     * Call the stage hook if one is set.
+     */
+    void CallStageHook(ToolkitStage stage, int pageIdx, bool end)
+    {
+        if (m_stageHook) m_stageHook(stage, pageIdx, end);
+    }
+
+    /**
+     * @name Methods for the cache of the layouts
+     * GetLayoutCacheFile returns the file of the cache for the data and the current options.
+     * CastOffFromLayoutCache returns false if the cache has no layout that can be applied to the document.
+     */
+    ///@{
+    std::string GetLayoutCacheFile(const std::string &data);
+    bool CastOffFromLayoutCache(const std::string &filename);
+    void AddToLayoutCache(const std::string &filename);
+    ///@}
+
+    /**
+     * @name Methods for the cache of the pages rendered in SVG
+     * The key is the page index and the render options (scale, bounding boxes, xml declaration, adjusted page height)
+     * Since the cache is cleared whenever the layout changes, the key does not need the layout itself.
+     */
+    ///@{
+    typedef std::tuple<int, int, bool, bool, bool> SvgCacheKey;
+    const std::string *GetCachedSvg(const SvgCacheKey &key);
+    void AddCachedSvg(const SvgCacheKey &key, const std::string &svg);
+    void ClearSvgCache();
+    ///@}
+
 protected:
 #ifdef USE_EMSCRIPTEN
     /**
@@ -412,6 +622,7 @@ private:
 
     bool m_noLayout;
     bool m_ignoreLayout;
+    bool m_incrementalLayout;
     int m_humType = 0;
     bool m_adjustPageHeight;
     std::vector<std::string> m_appXPathQueries;
@@ -424,9 +635,46 @@ private:
     // for debugging
     bool m_noJustification;
     bool m_showBoundingBoxes;
+    std::string m_layoutCacheDir;
+
+    /**
+     * @name The options of the current layout not stored in the document
+     */
+    ///@{
+    MusicFont *m_layoutFont;
+    bool m_layoutIncremental;
+    ///@}
+
+    /**
+     * True when the document was cast off according to its encoded breaks (pb and sb)
+     */
+    bool m_layoutFromEncoding;
+
+    /** The function called for each stage (see SetStageHook) */
+    std::function<void(ToolkitStage stage, int pageIdx, bool end)> m_stageHook;
+
+    /**
+     * @name The cache of the pages rendered in SVG, the most recently used first, and its size in bytes
+     */
+    ///@{
+    std::list<std::pair<SvgCacheKey, std::string> > m_svgCache;
+    std::map<SvgCacheKey, std::list<std::pair<SvgCacheKey, std::string> >::iterator> m_svgCacheIndex;
+    int m_svgCacheSize;
+    size_t m_svgCacheBytes;
+    ///@}
+
+    /**
+     * @name The MEI data indexed by IndexMdivs and its index
+     */
+    ///@{
+    std::string m_mdivData;
+    MeiMdivIndex m_mdivIndex;
+    ///@}
 
-    static char *m_humdrumBuffer;
-    char *m_cString;
+    /** The Humdrum data of the toolkit, with the filters applied */
+    std::string m_humdrumBuffer;
+    std::string m_cString;
+    std::string m_binaryBuffer;
 };
 
 } // namespace vrv
@@ -8,6 +8,10 @@
 #ifndef __VRV_VERTICAL_ALIGNER_H__
 #define __VRV_VERTICAL_ALIGNER_H__
 
+#include <map>
+
+//----------------------------------------------------------------------------
+
 #include "atts_shared.h"
 #include "object.h"
 
@@ -70,6 +74,66 @@ private:
     StaffAlignment *m_bottomAlignment;
 };
 
+//----------------------------------------------------------------------------
+// OverflowBBoxes
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the overflowing bounding boxes above or below a staff.
+ * The boxes are kept in the order they are added and are also indexed by their horizontal position.
+ * The index groups the boxes by width classes (powers of 2) sorted by their left position. Looking for the
+ * boxes overlapping horizontally with a given one is O(log n) per width class instead of a linear scan.
+ */
+class OverflowBBoxes {
+public:
+    OverflowBBoxes() {}
+    ~OverflowBBoxes() {}
+
+    /**
+     * Clear the boxes and the index
+     */
+    void Clear();
+
+    /**
+     * Add a box at the end of the list.
+     * The horizontal position of the box must not change while it is in the list.
+     */
+    void Add(BoundingBox *box);
+
+    /**
+     * Fill overlaps with the boxes that have a horizontal content overlap with the box.
+     * This gives the same result as a loop with BoundingBox::HorizontalContentOverlap over the boxes,
+     * including the order in which the boxes were added.
+     */
+    void FindHorizontalContentOverlaps(const BoundingBox *box, ArrayOfBoundingBoxes &overlaps) const;
+
+    /**
+     * Return the boxes in the order they were added
+     */
+    const ArrayOfBoundingBoxes *GetBoxes() const { return &m_boxes; }
+
+private:
+    /**
+     * Return the width class of a box, i.e., the number of bits of its width
+     */
+    static int GetWidthClass(int width);
+
+public:
+    //
+private:
+    /**
+     * The boxes in the order they were added
+     */
+    ArrayOfBoundingBoxes m_boxes;
+
+    /**
+     * The index of the boxes with a content bounding box.
+     * The key is the width class, the value maps the left position to the right position and the box index in
+     * m_boxes.
+     */
+    std::map<int, std::multimap<int, std::pair<int, int> > > m_index;
+};
+
 //----------------------------------------------------------------------------
 // StaffAlignment
 //----------------------------------------------------------------------------
@@ -150,8 +214,8 @@ public:
      * @name Adds a bounding box to the array of overflowing objects above or below
      */
     ///@{
-    void AddBBoxAbove(BoundingBox *box) { m_overflowAboveBBoxes.push_back(box); }
-    void AddBBoxBelow(BoundingBox *box) { m_overflowBelowBBoxes.push_back(box); }
+    void AddBBoxAbove(BoundingBox *box) { m_overflowAboveBBoxes.Add(box); }
+    void AddBBoxBelow(BoundingBox *box) { m_overflowBelowBBoxes.Add(box); }
     ///@}
 
     /**
@@ -225,8 +289,8 @@ private:
     /**
      * The list of overflowing bounding boxes (e.g, LayerElement or FloatingPositioner)
      */
-    std::vector<BoundingBox *> m_overflowAboveBBoxes;
-    std::vector<BoundingBox *> m_overflowBelowBBoxes;
+    OverflowBBoxes m_overflowAboveBBoxes;
+    OverflowBBoxes m_overflowBelowBBoxes;
 };
 
 } // namespace vrv
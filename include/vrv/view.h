@@ -139,6 +139,14 @@ public:
      */
     void DrawCurrentPage(DeviceContext *dc, bool background = true);
 
+    /**
+     * Method that draws a single system of the current page.
+     * This is used for filling the bounding boxes system by system in Page::LayOutVertically.
+     * View::SetPage has to be called before.
+     * Defined in view_page.cpp
+     */
+    void DrawCurrentPageSystem(DeviceContext *dc, System *system);
+
     /**
      * Return the pixel per unit factor of the current page (if any, 1.0 otherwise)
      */
@@ -9,9 +9,11 @@
 #define __VRV_H__
 
 #include <cstring>
+#include <functional>
 #include <map>
 #include <stdarg.h>
 #include <stdio.h>
+#include <streambuf>
 #include <string>
 #include <vector>
 
@@ -23,6 +25,7 @@
 
 namespace vrv {
 
+class FontInfo;
 class Glyph;
 class Object;
 
@@ -86,6 +89,12 @@ std::string GetFilename(std::string fullpath);
  */
 std::string GetVersion();
 
+/**
+ * Return the 64-bit FNV-1a hash of the data, continuing from a previous hash if one is given.
+ * This is not a cryptographic hash and is meant only for identifying content (e.g., in a cache).
+ */
+unsigned long long HashData(const std::string &data, unsigned long long hash = 14695981039346656037ULL);
+
 /**
  *
  */
@@ -106,6 +115,21 @@ extern struct timeval start;
 void LogElapsedTimeStart();
 void LogElapsedTimeEnd(const char *msg = "unspecified operation");
 
+/**
+ * The number of threads of the pool of the threaded Emscripten build (see PTHREAD_POOL_SIZE in buildToolkit).
+ * No more threads can be started by ProcessConcurrently since they cannot be created while waiting for them.
+ */
+#if defined(USE_EMSCRIPTEN) && !defined(VRV_PTHREAD_POOL_SIZE)
+#define VRV_PTHREAD_POOL_SIZE 8
+#endif
+
+/**
+ * Call func for each index in [0, size[, distributing the calls over the available cores.
+ * The calls are made in an undefined order and func must not modify any state shared between indexes.
+ * With NO_THREAD_SUPPORT, the calls are made sequentially in the calling thread.
+ */
+void ProcessConcurrently(int size, const std::function<void(int)> &func);
+
 /**
  * Method that simply checks if the Object is not NULL
  * Also asserts it for stopping in debug mode
@@ -116,9 +140,67 @@ bool Check(Object *object);
 // Resources
 //----------------------------------------------------------------------------
 
+/**
+ * The range of the SMuFL codes (in the Unicode Private Use Area) for which glyphs are looked up in a table.
+ */
+#define SMUFL_FIRST_CODE 0xE000
+#define SMUFL_LAST_CODE 0xF8FF
+
+/**
+ * The variants of the text font, each with its own metrics.
+ */
+enum TextFontVariant { TEXT_REGULAR = 0, TEXT_ITALIC, TEXT_BOLD, TEXT_BOLD_ITALIC, TEXT_VARIANT_COUNT };
+
+//----------------------------------------------------------------------------
+// MusicFont
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the glyphs of a SMuFL font.
+ * The fonts are loaded by Resources::GetMusicFont and are never modified or deleted afterwards, so they can be used
+ * by several documents at the same time without locking.
+ */
+class MusicFont {
+public:
+    /**
+     * @name Constructors, destructors, and other standard methods
+     * The glyph table points to the glyphs, so fonts cannot be copied.
+     */
+    ///@{
+    MusicFont();
+    MusicFont(const MusicFont &) = delete;
+    MusicFont &operator=(const MusicFont &) = delete;
+    ///@}
+
+    /** Returns the name of the font */
+    std::string GetName() const { return m_name; }
+    /** Returns the glyph (if exists) of the font */
+    Glyph *GetGlyph(wchar_t smuflCode);
+    /** Returns the number of glyphs of the font */
+    int GetGlyphCount() const { return (int)m_glyphs.size(); }
+
+private:
+    friend class Resources;
+
+    /** The name of the font */
+    std::string m_name;
+    /** The glyphs of the font, including the ones of Leipzig and Bravura missing in the font */
+    std::map<wchar_t, Glyph> m_glyphs;
+    /** The glyphs indexed by their code from SMUFL_FIRST_CODE (NULL if not in the font) */
+    std::vector<Glyph *> m_glyphTable;
+};
+
+//----------------------------------------------------------------------------
+// Resources
+//----------------------------------------------------------------------------
+
 /**
  * This class provides static resource values.
  * The default values can be changed by setters.
+ * The resources are shared by all the toolkit instances of the process. Loading them is thread-safe and each font is
+ * loaded only once, so toolkits can be created and used concurrently. Each document has its own music font, which
+ * can be changed without affecting the other ones. Changing the path should not be done while another instance is
+ * rendering since the text font is loaded again.
  */
 
 class Resources {
@@ -128,30 +210,57 @@ public:
      */
     ///@{
     /** Resource path */
-    static std::string GetPath() { return m_path; }
-    static void SetPath(std::string path) { m_path = path; }
+    static std::string GetPath();
+    static void SetPath(std::string path);
     /** Init the SMufL music and text fonts */
     static bool InitFonts();
-    /** Init the text font (bounding boxes and ASCII only) */
+    /**
+     * Init the text font variants (bounding boxes).
+     * The files in data/text cover only ASCII and a few Latin characters (184 glyphs).
+     */
     static bool InitTextFont();
-    /** Select a particular font */
+    /** Select the default font of the documents (loading it if necessary) */
     static bool SetFont(std::string fontName);
-    /** Returns the glyph (if exists) for the current SMuFL font */
-    static Glyph *GetGlyph(wchar_t smuflCode);
-    /** Returns the glyph (if exists) for the text font (bounding box and ASCII only) */
-    static Glyph *GetTextGlyph(wchar_t code);
+    /**
+     * Returns the music font with the name from the resource path, loading it the first time.
+     * Returns NULL if the font cannot be loaded.
+     */
+    static MusicFont *GetMusicFont(const std::string &fontName);
+    /** Returns the default music font (NULL if the fonts are not initialized) */
+    static MusicFont *GetDefaultMusicFont();
+    /**
+     * Returns the glyph (if exists) for the text font variant (bounding box only).
+     * Wide characters (e.g., CJK) missing in the font get a glyph of the width of an em.
+     * For the other characters missing in the font, NULL is returned and the callers use the 'o' instead.
+     */
+    static Glyph *GetTextGlyph(wchar_t code, TextFontVariant variant = TEXT_REGULAR);
+    /** Returns the text font variant for the style and the weight of a font */
+    static TextFontVariant GetTextFontVariant(FontInfo *font);
     ///@}
 
 private:
-    static bool LoadFont(std::string fontName);
+    static bool LoadFont(MusicFont *musicFont, std::string fontName);
+    static bool LoadTextFont(std::string fileName, TextFontVariant variant);
+    static bool IsWideChar(wchar_t code);
 
 private:
     /** The path to the resources directory (e.g., for the svg/ subdirectory with fonts as XML */
     static std::string m_path;
-    /** The loaded SMuFL font */
-    static std::map<wchar_t, Glyph> m_font;
-    /** A text font used for bounding box calculations */
-    static std::map<wchar_t, Glyph> m_textFont;
+    /** The music fonts loaded so far, by path and name */
+    static std::map<std::string, MusicFont> m_musicFonts;
+    /** The default music font */
+    static MusicFont *m_defaultMusicFont;
+    /** The text font variants used for bounding box calculations */
+    static std::map<wchar_t, Glyph> m_textFont[TEXT_VARIANT_COUNT];
+    /**
+     * The glyphs of the text font variants indexed by their code in the Unicode BMP, in 256 blocks of 256 codes.
+     * A block is empty when the font has no glyph in it, which is the case for most of them.
+     */
+    static std::vector<std::vector<Glyph *> > m_textGlyphTable[TEXT_VARIANT_COUNT];
+    /** The glyph used for the wide characters missing in the text font variants */
+    static Glyph m_textWideGlyph[TEXT_VARIANT_COUNT];
+    /** The path the text font variants were loaded from */
+    static std::string m_textFontPath;
 };
 
 //----------------------------------------------------------------------------
@@ -160,6 +269,26 @@ private:
 
 std::string Base64Encode(unsigned char const *, unsigned int len);
 
+//----------------------------------------------------------------------------
+// StringOutputBuffer
+//----------------------------------------------------------------------------
+
+/**
+ * A stream buffer appending the output to a string.
+ * It is used for writing binary data to a std::ostream without the copies of a std::stringstream.
+ */
+class StringOutputBuffer : public std::streambuf {
+public:
+    StringOutputBuffer(std::string *output) { m_output = output; }
+
+protected:
+    virtual int_type overflow(int_type c);
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+
+private:
+    std::string *m_output;
+};
+
 } // namespace vrv
 
 #endif
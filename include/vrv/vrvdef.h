@@ -199,6 +199,7 @@ class BoundingBox;
 class FloatingPositioner;
 class LayerElement;
 class LedgerLine;
+class Measure;
 class Note;
 class Object;
 class Point;
@@ -234,6 +235,12 @@ typedef std::vector<LedgerLine> ArrayOfLedgerLines;
 
 typedef std::map<Staff *, std::list<int> > MapOfDotLocs;
 
+typedef std::vector<std::tuple<int, double, double, int, Note *> > ArrayOfMIDINoteTuples;
+
+typedef std::map<std::pair<int, int>, ArrayOfMIDINoteTuples> MapOfMIDINoteTuples;
+
+typedef std::map<const Measure *, MapOfMIDINoteTuples> MapOfMeasureMIDINoteTuples;
+
 //----------------------------------------------------------------------------
 // Global defines
 //----------------------------------------------------------------------------
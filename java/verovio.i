@@ -12,12 +12,16 @@
 
 // Method to ignore
 %ignore vrv::Toolkit::GetShowBoundingBoxes( );
+%ignore vrv::Toolkit::GetBinaryBuffer( );
 %ignore vrv::Toolkit::GetCString( );
+%ignore vrv::Toolkit::GetCStringLength;
 %ignore vrv::Toolkit::GetLogString( );
 %ignore vrv::Toolkit::ParseOptions( const std::string & );
+%ignore vrv::Toolkit::ReleaseCString( );
 %ignore vrv::Toolkit::ResetLogBuffer( );
 %ignore vrv::Toolkit::SetShowBoundingBoxes( bool );
 %ignore vrv::Toolkit::SetCString( const std::string & );
+%ignore vrv::Toolkit::SetCString( std::string && );
 
 %module verovio
 %include "std_string.i"
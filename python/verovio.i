@@ -11,16 +11,72 @@
 // Method to ignore
 %ignore vrv::Toolkit::GetShowBoundingBoxes( );
 %ignore vrv::Toolkit::GetCString( );
+%ignore vrv::Toolkit::GetCStringLength;
 %ignore vrv::Toolkit::GetLogString( );
 //%ignore vrv::Toolkit::ParseOptions( const std::string & );
+%ignore vrv::Toolkit::ReleaseCString( );
 %ignore vrv::Toolkit::ResetLogBuffer( );
 %ignore vrv::Toolkit::SetShowBoundingBoxes( bool );
+%ignore vrv::Toolkit::SetStageHook;
 %ignore vrv::Toolkit::SetCString( const std::string & );
+%ignore vrv::Toolkit::SetCString( std::string && );
 
-%module verovio
+// The GIL is released during the long running methods listed below so that several toolkit instances can be used
+// concurrently from Python threads - all other methods keep it
+%module(threads="1") verovio
 %include "std_string.i"
+
+%nothread;
+%thread vrv::Toolkit::Edit;
+%thread vrv::Toolkit::GetElementsAtTime;
+%thread vrv::Toolkit::GetHumdrum;
+%thread vrv::Toolkit::GetMEI;
+%thread vrv::Toolkit::GetMEIBytes;
+%thread vrv::Toolkit::GetPageCount;
+%thread vrv::Toolkit::GetPageWithElement;
+%thread vrv::Toolkit::GetTimeForElement;
+%thread vrv::Toolkit::IndexMdivs;
+%thread vrv::Toolkit::LoadData;
+%thread vrv::Toolkit::LoadFile;
+%thread vrv::Toolkit::LoadMdiv;
+%thread vrv::Toolkit::RedoLayout;
+%thread vrv::Toolkit::RedoPagePitchPosLayout;
+%thread vrv::Toolkit::RenderToMidi;
+%thread vrv::Toolkit::RenderToMidiBuffer;
+%thread vrv::Toolkit::RenderToMidiFile;
+%thread vrv::Toolkit::RenderToSvg;
+%thread vrv::Toolkit::RenderToSvgBytes;
+%thread vrv::Toolkit::RenderToSvgFile;
+%thread vrv::Toolkit::SaveFile;
+%thread vrv::Toolkit::SelectReadings;
+
+// Return the strings without copying them once more before the conversion
+%typemap(out) std::string {
+    $result = SWIG_FromCharPtrAndSize($1.data(), $1.size());
+}
+
+// Return the binary buffer as bytes
+%typemap(out) const std::string &GetBinaryBuffer {
+    $result = PyBytes_FromStringAndSize($1->data(), $1->size());
+}
+
+// Return the SVG and the MEI as UTF-8 bytes, which avoids decoding them for writing them to a file or a socket
+%typemap(out) std::string RenderToSvgBytes, std::string GetMEIBytes {
+    $result = PyBytes_FromStringAndSize($1.data(), $1.size());
+}
 %include "../include/vrv/toolkit.h"
 
+%extend vrv::Toolkit {
+    std::string RenderToSvgBytes(int pageNo = 1, bool xml_declaration = false)
+    {
+        return $self->RenderToSvg(pageNo, xml_declaration);
+    }
+    std::string GetMEIBytes(int pageNo = 0, bool scoreBased = false)
+    {
+        return $self->GetMEI(pageNo, scoreBased);
+    }
+}
+
 
 %{
     #include "../include/vrv/toolkit.h"
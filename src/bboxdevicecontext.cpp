@@ -288,7 +288,7 @@ void BBoxDeviceContext::DrawMusicText(const std::wstring &text, int x, int y, bo
 
     for (unsigned int i = 0; i < text.length(); i++) {
         wchar_t c = text.at(i);
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = m_musicFont->GetGlyph(c);
         if (!glyph) {
             continue;
         }
@@ -311,7 +311,7 @@ void BBoxDeviceContext::DrawSpline(int n, Point points[])
 {
 }
 
-void BBoxDeviceContext::UpdateBB(int x1, int y1, int x2, int y2, wchar_t glyph)
+void BBoxDeviceContext::DrawMusicGlyph(wchar_t code, int x, int y, int fontSize, bool setSmuflGlyph)
 {
     if (m_isDeactivatedX && m_isDeactivatedY) {
         return;
@@ -320,22 +320,65 @@ void BBoxDeviceContext::UpdateBB(int x1, int y1, int x2, int y2, wchar_t glyph)
     // the array may not be empty
     assert(!m_objects.empty());
 
+    Object *object = m_objects.back();
+
+    int x1, y1, x2, y2;
+    // The extents depend on the font, which can change between two layouts
+    if (!object->GetCachedGlyphExtents(code, m_musicFont, fontSize, x1, y1, x2, y2)) {
+        Glyph *glyph = m_musicFont->GetGlyph(code);
+        if (!glyph) {
+            return;
+        }
+        int g_x, g_y, g_w, g_h;
+        glyph->GetBoundingBox(g_x, g_y, g_w, g_h);
+
+        // same values as in DrawMusicText but without the flipping of the y position
+        x1 = g_x * fontSize / glyph->GetUnitsPerEm();
+        y1 = g_y * fontSize / glyph->GetUnitsPerEm();
+        x2 = x1 + g_w * fontSize / glyph->GetUnitsPerEm();
+        y2 = y1 + g_h * fontSize / glyph->GetUnitsPerEm();
+        object->SetCachedGlyphExtents(code, m_musicFont, fontSize, x1, y1, x2, y2);
+    }
+
+    UpdateLogicalBB(x + x1, y + y1, x + x2, y + y2, (setSmuflGlyph) ? code : 0, fontSize);
+}
+
+void BBoxDeviceContext::UpdateBB(int x1, int y1, int x2, int y2, wchar_t glyph)
+{
+    if (m_isDeactivatedX && m_isDeactivatedY) {
+        return;
+    }
+
     // we need to store logical coordinates in the objects, we need to convert them back (this is why we need a View
     // object)
+    int fontSize = (glyph != 0) ? m_fontStack.top()->GetPointSize() : 0;
+    UpdateLogicalBB(m_view->ToLogicalX(x1), m_view->ToLogicalY(y1), m_view->ToLogicalX(x2), m_view->ToLogicalY(y2),
+        glyph, fontSize);
+}
+
+void BBoxDeviceContext::UpdateLogicalBB(int x1, int y1, int x2, int y2, wchar_t glyph, int fontSize)
+{
+    if (m_isDeactivatedX && m_isDeactivatedY) {
+        return;
+    }
+
+    // the array may not be empty
+    assert(!m_objects.empty());
+
     if (!m_isDeactivatedX) {
-        (m_objects.back())->UpdateSelfBBoxX(m_view->ToLogicalX(x1), m_view->ToLogicalX(x2));
-        if (glyph != 0) (m_objects.back())->SetBoundingBoxGlyph(glyph, m_fontStack.top()->GetPointSize());
+        (m_objects.back())->UpdateSelfBBoxX(x1, x2);
+        if (glyph != 0) (m_objects.back())->SetBoundingBoxGlyph(glyph, fontSize);
     }
     if (!m_isDeactivatedY) {
-        (m_objects.back())->UpdateSelfBBoxY(m_view->ToLogicalY(y1), m_view->ToLogicalY(y2));
-        if (glyph != 0) (m_objects.back())->SetBoundingBoxGlyph(glyph, m_fontStack.top()->GetPointSize());
+        (m_objects.back())->UpdateSelfBBoxY(y1, y2);
+        if (glyph != 0) (m_objects.back())->SetBoundingBoxGlyph(glyph, fontSize);
     }
 
     int i;
     // Stretch the content BB of the other objects
     for (i = 0; i < (int)m_objects.size(); i++) {
-        if (!m_isDeactivatedX) (m_objects.at(i))->UpdateContentBBoxX(m_view->ToLogicalX(x1), m_view->ToLogicalX(x2));
-        if (!m_isDeactivatedY) (m_objects.at(i))->UpdateContentBBoxY(m_view->ToLogicalY(y1), m_view->ToLogicalY(y2));
+        if (!m_isDeactivatedX) (m_objects.at(i))->UpdateContentBBoxX(x1, x2);
+        if (!m_isDeactivatedY) (m_objects.at(i))->UpdateContentBBoxY(y1, y2);
     }
 }
 
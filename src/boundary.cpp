@@ -16,6 +16,7 @@
 #include "ending.h"
 #include "functorparams.h"
 #include "system.h"
+#include "timemap.h"
 #include "vrv.h"
 
 namespace vrv {
@@ -154,6 +155,17 @@ int BoundaryEnd::PrepareFloatingGrps(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int BoundaryEnd::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    params->m_timemap->EndSection();
+
+    return FUNCTOR_CONTINUE;
+}
+
 //----------------------------------------------------------------------------
 // Interface pseudo functor (redirected)
 //----------------------------------------------------------------------------
@@ -24,8 +24,6 @@
 
 namespace vrv {
 
-int BoundingBox::s_deCasteljau[4][4];
-
 //----------------------------------------------------------------------------
 // BoundingBox
 //----------------------------------------------------------------------------
@@ -41,6 +39,10 @@ BoundingBox::BoundingBox()
     rect2[0] = Point(25, 25);
     rect2[1] = Point(100, 100);
 
+    m_cachedGlyph = 0;
+    m_cachedGlyphFont = NULL;
+    m_cachedGlyphFontSize = 0;
+
     ResetBoundingBox();
 }
 
@@ -197,6 +199,33 @@ void BoundingBox::SetBoundingBoxGlyph(wchar_t smuflGlyph, int fontSize)
     m_smuflGlyphFontSize = fontSize;
 }
 
+void BoundingBox::SetCachedGlyphExtents(
+    wchar_t smuflGlyph, const MusicFont *musicFont, int fontSize, int x1, int y1, int x2, int y2)
+{
+    assert(smuflGlyph);
+    assert(musicFont);
+    m_cachedGlyph = smuflGlyph;
+    m_cachedGlyphFont = musicFont;
+    m_cachedGlyphFontSize = fontSize;
+    m_cachedGlyphExtents[0] = x1;
+    m_cachedGlyphExtents[1] = y1;
+    m_cachedGlyphExtents[2] = x2;
+    m_cachedGlyphExtents[3] = y2;
+}
+
+bool BoundingBox::GetCachedGlyphExtents(
+    wchar_t smuflGlyph, const MusicFont *musicFont, int fontSize, int &x1, int &y1, int &x2, int &y2) const
+{
+    if ((m_cachedGlyph != smuflGlyph) || (m_cachedGlyphFont != musicFont) || (m_cachedGlyphFontSize != fontSize)) {
+        return false;
+    }
+    x1 = m_cachedGlyphExtents[0];
+    y1 = m_cachedGlyphExtents[1];
+    x2 = m_cachedGlyphExtents[2];
+    y2 = m_cachedGlyphExtents[3];
+    return true;
+}
+
 bool BoundingBox::HorizontalContentOverlap(const BoundingBox *other, int margin) const
 {
     assert(other);
@@ -318,7 +347,7 @@ int BoundingBox::GetRectangles(
     bool glyphRect = true;
 
     if (m_smuflGlyph != 0) {
-        glyph = Resources::GetGlyph(m_smuflGlyph);
+        glyph = doc->GetMusicFont()->GetGlyph(m_smuflGlyph);
         assert(glyph);
 
         if (glyph->HasAnchor(anchor1) && glyph->HasAnchor(anchor2)) {
@@ -719,15 +748,16 @@ int BoundingBox::CalcBezierAtPosition(const Point bezier[4], int x)
     if (bezier[3].x != bezier[0].x) t = (double)(x - bezier[0].x) / (double)(bezier[3].x - bezier[0].x);
     t = std::min(1.0, std::max(0.0, t));
     int n = 4;
+    // Buffer for De-Casteljau algorithm (local since the method can be called concurrently)
+    int deCasteljau[4][4];
 
-    for (i = 0; i < n; i++) BoundingBox::s_deCasteljau[0][i] = bezier[i].y;
+    for (i = 0; i < n; i++) deCasteljau[0][i] = bezier[i].y;
     for (j = 1; j < n; j++) {
         for (int i = 0; i < 4 - j; i++) {
-            BoundingBox::s_deCasteljau[j][i]
-                = BoundingBox::s_deCasteljau[j - 1][i] * (1 - t) + BoundingBox::s_deCasteljau[j - 1][i + 1] * t;
+            deCasteljau[j][i] = deCasteljau[j - 1][i] * (1 - t) + deCasteljau[j - 1][i + 1] * t;
         }
     }
-    return BoundingBox::s_deCasteljau[n - 1][0];
+    return deCasteljau[n - 1][0];
 }
 
 void BoundingBox::CalcThickBezier(
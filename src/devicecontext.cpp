@@ -119,18 +119,21 @@ void DeviceContext::GetTextExtent(const std::string &string, TextExtend *extend)
 void DeviceContext::GetTextExtent(const std::wstring &string, TextExtend *extend)
 {
     assert(m_fontStack.top());
+    assert(m_musicFont);
     assert(extend);
 
     extend->m_width = 0;
     extend->m_height = 0;
 
-    Glyph *unkown = Resources::GetTextGlyph(L'o');
+    // The metrics of the bold and italic variants are used when the font is bold or italic
+    TextFontVariant variant = Resources::GetTextFontVariant(m_fontStack.top());
+    Glyph *unkown = Resources::GetTextGlyph(L'o', variant);
 
     for (unsigned int i = 0; i < string.length(); i++) {
         wchar_t c = string[i];
-        Glyph *glyph = Resources::GetTextGlyph(c);
+        Glyph *glyph = Resources::GetTextGlyph(c, variant);
         if (!glyph) {
-            glyph = Resources::GetGlyph(c);
+            glyph = m_musicFont->GetGlyph(c);
         }
         if (!glyph) {
             glyph = unkown;
@@ -142,6 +145,7 @@ void DeviceContext::GetTextExtent(const std::wstring &string, TextExtend *extend
 void DeviceContext::GetSmuflTextExtent(const std::wstring &string, TextExtend *extend)
 {
     assert(m_fontStack.top());
+    assert(m_musicFont);
     assert(extend);
 
     extend->m_width = 0;
@@ -149,7 +153,7 @@ void DeviceContext::GetSmuflTextExtent(const std::wstring &string, TextExtend *e
 
     for (unsigned int i = 0; i < string.length(); i++) {
         wchar_t c = string[i];
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = m_musicFont->GetGlyph(c);
         if (!glyph) {
             continue;
         }
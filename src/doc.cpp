@@ -11,6 +11,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <set>
 
 //----------------------------------------------------------------------------
 
@@ -35,6 +36,7 @@
 #include "staff.h"
 #include "syl.h"
 #include "system.h"
+#include "tie.h"
 #include "verse.h"
 #include "vrv.h"
 
@@ -54,6 +56,8 @@ Doc::Doc() : Object("doc-")
 
     // owned pointers need to be set to NULL;
     m_scoreBuffer = NULL;
+    m_castOffPendingPage = NULL;
+    m_musicFont = Resources::GetDefaultMusicFont();
     Reset();
 }
 
@@ -88,6 +92,14 @@ void Doc::Reset()
     m_currentScoreDefDone = false;
     m_drawingPreparationDone = false;
     m_midiExportDone = false;
+    m_timemap.Reset();
+    m_midiCache.clear();
+
+    // The pending page is owned by the document and deleted by Object::Reset
+    m_castOffPendingPage = NULL;
+    m_castOffChunkSize = 0;
+    m_castOffScoreDefWidth = 0;
+    m_castOffLongestActualDur = VRV_UNSET;
 
     m_scoreDef.Reset();
     if (m_scoreBuffer) {
@@ -97,6 +109,9 @@ void Doc::Reset()
 
     m_drawingSmuflFontSize = 0;
     m_drawingLyricFontSize = 0;
+
+    m_glyphMetricsFontSize = 0;
+    m_glyphMetricsFont = NULL;
 }
 
 void Doc::SetType(DocType type)
@@ -176,85 +191,177 @@ bool Doc::GenerateDocumentScoreDef()
 
 void Doc::ExportMIDI(MidiFile *midiFile)
 {
-    CalcMaxMeasureDurationParams calcMaxMeasureDurationParams;
-
-    // We first calculate the maximum duration of each measure
-    Functor calcMaxMeasureDuration(&Object::CalcMaxMeasureDuration);
-    this->Process(&calcMaxMeasureDuration, &calcMaxMeasureDurationParams);
-
-    // We need to populate processing lists for processing the document by Layer (by Verse will not be used)
-    PrepareProcessingListsParams prepareProcessingListsParams;
-    // Alternate solution with StaffN_LayerN_VerseN_t (see also Verse::PrepareDrawing)
-    // StaffN_LayerN_VerseN_t staffLayerVerseTree;
-    // params.push_back(&staffLayerVerseTree);
-
-    // We first fill a tree of int with [staff/layer] and [staff/layer/verse] numbers (@n) to be process
-    Functor prepareProcessingLists(&Object::PrepareProcessingLists);
-    this->Process(&prepareProcessingLists, &prepareProcessingListsParams);
-
-    // The tree is used to process each staff/layer/verse separatly
-    // For this, we use a array of AttCommmonNComparison that looks for each object if it is of the type
-    // and with @n specified
-
-    IntTree_t::iterator staves;
-    IntTree_t::iterator layers;
+    m_timemap.Reset();
+    CalcMaxMeasureDurationParams calcMaxMeasureDurationParams(&m_timemap);
+
+    // We first calculate the maximum duration of each measure and collect the structure and the tempo changes
+    // The content of the measures that have not been modified since the previous export is not processed
+    Functor calcMaxMeasureDuration(&Object::CalcMaxMeasureDuration, "CalcMaxMeasureDuration");
+    Functor calcMaxMeasureDurationEnd(&Object::CalcMaxMeasureDurationEnd, "CalcMaxMeasureDurationEnd");
+    this->Process(&calcMaxMeasureDuration, &calcMaxMeasureDurationParams, &calcMaxMeasureDurationEnd);
+
+    // The timemap gives the start time of each measure in the score and each time it is played
+    double bpm = Timemap::GetMidiTempoBpm(&m_scoreDef);
+    bool hasTempo = (bpm > 0.0);
+    if (!hasTempo) bpm = TIMEMAP_DEFAULT_BPM;
+    m_timemap.Build(calcMaxMeasureDurationParams.m_maxValues, bpm);
+
+    // Process notes and chords, rests, spaces in a single pass - the notes are collected for each staff/layer
+    // The notes of the measures that have not been modified are taken from the cache
+    GenerateMIDIParams generateMIDIParams(&m_midiCache);
+    Functor generateMIDI(&Object::GenerateMIDI, "GenerateMIDI");
+    Functor generateMIDIEnd(&Object::GenerateMIDIEnd, "GenerateMIDIEnd");
+    this->Process(&generateMIDI, &generateMIDIParams, &generateMIDIEnd);
+
+    // Only the measures still in the document are kept in the cache
+    m_midiCache.swap(generateMIDIParams.m_measureNotes);
+
+    // The MIDI data of the measures processed again is now cached
+    std::vector<Measure *>::iterator measureIter;
+    for (measureIter = calcMaxMeasureDurationParams.m_modifiedMeasures.begin();
+         measureIter != calcMaxMeasureDurationParams.m_modifiedMeasures.end(); ++measureIter) {
+        (*measureIter)->m_midiCacheValid = true;
+    }
 
-    // Set tempo
-    if (m_scoreDef.HasMidiBpm()) {
-        midiFile->addTempo(0, 0, m_scoreDef.GetMidiBpm());
+    // The notes are ordered by staff/layer, so the layers of each staff follow each other
+    // Get the first layer and the transposition (semi-tone) value for each staff
+    std::vector<int> staffNs;
+    std::vector<int> transSemis;
+    std::vector<MapOfMIDINoteTuples::iterator> staffLayers;
+    MapOfMIDINoteTuples::iterator layers;
+    for (layers = generateMIDIParams.m_layerNotes.begin(); layers != generateMIDIParams.m_layerNotes.end();
+         ++layers) {
+        if (!staffNs.empty() && (layers->first.first == staffNs.back())) continue;
+        int transSemi = 0;
+        StaffDef *staffDef = this->m_scoreDef.GetStaffDef(layers->first.first);
+        if (staffDef && staffDef->HasTransSemi()) transSemi = staffDef->GetTransSemi();
+        staffNs.push_back(layers->first.first);
+        transSemis.push_back(transSemi);
+        staffLayers.push_back(layers);
+    }
+    staffLayers.push_back(generateMIDIParams.m_layerNotes.end());
+
+    // The events of each staff are created and sorted from its notes only, so the staves can be done concurrently
+    // This is the only concurrent part of the export - the passes over the document above and the tracks below are not
+    std::vector<MidiEventList> staffEvents(staffNs.size());
+    ProcessConcurrently((int)staffNs.size(), [this, midiFile, &transSemis, &staffLayers, &staffEvents](int i) {
+        this->GenerateMIDIStaff(staffLayers.at(i), staffLayers.at(i + 1), transSemis.at(i), &staffEvents.at(i));
+        midiFile->sortTrack(staffEvents.at(i));
+    });
+
+    // Set tempo - the initial one is not needed when it is the default one
+    int i, j;
+    for (i = 0; i < m_timemap.GetTempoCount(); i++) {
+        if ((i == 0) && !hasTempo && (m_timemap.GetTempoBpm(i) == TIMEMAP_DEFAULT_BPM)) continue;
+        midiFile->addTempo(0, (int)m_timemap.GetTempoTime(i), m_timemap.GetTempoBpm(i));
     }
 
-    // Process notes and chords, rests, spaces layer by layer
+    // Add the events to the tracks staff by staff
     // track 0 (included by default) is reserved for meta messages common to all tracks
     int midiTrack = 1;
-    std::vector<AttComparison *> filters;
-    for (staves = prepareProcessingListsParams.m_layerTree.child.begin();
-         staves != prepareProcessingListsParams.m_layerTree.child.end(); ++staves) {
-
-        int transSemi = 0;
-        // Get the transposition (semi-tone) value for the staff
-        if (StaffDef *staffDef = this->m_scoreDef.GetStaffDef(staves->first)) {
-            if (staffDef->HasTransSemi()) transSemi = staffDef->GetTransSemi();
+    for (i = 0; i < (int)staffNs.size(); i++) {
+        StaffDef *staffDef = this->m_scoreDef.GetStaffDef(staffNs.at(i));
+        if (staffDef) {
             midiTrack = staffDef->GetN();
             midiFile->addTrack();
             if (staffDef->HasLabel()) midiFile->addTrackName(midiTrack, 0, staffDef->GetLabel());
         }
-
-        for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            filters.clear();
-            // Create ad comparison object for each type / @n
-            AttCommonNComparison matchStaff(STAFF, staves->first);
-            AttCommonNComparison matchLayer(LAYER, layers->first);
-            filters.push_back(&matchStaff);
-            filters.push_back(&matchLayer);
-
-            GenerateMIDIParams generateMIDIParams(midiFile);
-            generateMIDIParams.m_maxValues = calcMaxMeasureDurationParams.m_maxValues;
-            generateMIDIParams.m_midiTrack = midiTrack;
-            generateMIDIParams.m_transSemi = transSemi;
-            Functor generateMIDI(&Object::GenerateMIDI);
-            Functor generateMIDIEnd(&Object::GenerateMIDIEnd);
-
-            // LogDebug("Exporting track %d ----------------", midiTrack);
-            this->Process(&generateMIDI, &generateMIDIParams, &generateMIDIEnd, &filters);
+        // The events are owned by the track once added
+        MidiEventList &track = (*midiFile)[midiTrack];
+        for (j = 0; j < staffEvents.at(i).size(); j++) {
+            track.push_back_no_copy(&staffEvents.at(i)[j]);
         }
+        staffEvents.at(i).detach();
+        // The events of a staff without staffDef are added to the previous track, which has to be sorted again
+        if (!staffDef) midiFile->sortTrack(track);
     }
 
     m_midiExportDone = true;
 }
 
-void Doc::PrepareDrawing()
+void Doc::GenerateMIDIStaff(
+    MapOfMIDINoteTuples::iterator first, MapOfMIDINoteTuples::iterator last, int transSemi, MidiEventList *events)
+{
+    assert(events);
+
+    // Create the events layer by layer, for each time the measure of the note is played
+    int channel = 0;
+    int velocity = 64;
+    MapOfMIDINoteTuples::iterator layers;
+    ArrayOfMIDINoteTuples::iterator notes;
+    std::vector<double>::const_iterator times;
+    for (layers = first; layers != last; ++layers) {
+        for (notes = layers->second.begin(); notes != layers->second.end(); ++notes) {
+            // The start of the measure in the score changes when the duration of a previous measure changes
+            double scoreTime = m_timemap.GetScoreTime(std::get<0>(*notes));
+            Note *note = std::get<4>(*notes);
+            assert(note);
+            note->m_playingOnset = scoreTime + std::get<1>(*notes);
+            note->m_playingOffset = scoreTime + std::get<2>(*notes);
+
+            // Adjustment for transposition intruments
+            int pitch = std::get<3>(*notes) + transSemi;
+            const std::vector<double> &performanceTimes = m_timemap.GetPerformanceTimes(std::get<0>(*notes));
+            for (times = performanceTimes.begin(); times != performanceTimes.end(); ++times) {
+                MidiEvent *noteOn = new MidiEvent;
+                noteOn->makeNoteOn(channel, pitch, velocity);
+                noteOn->tick = (int)((*times) + std::get<1>(*notes));
+                events->push_back_no_copy(noteOn);
+                MidiEvent *noteOff = new MidiEvent;
+                noteOff->makeNoteOff(channel, pitch);
+                noteOff->tick = (int)((*times) + std::get<2>(*notes));
+                events->push_back_no_copy(noteOff);
+            }
+        }
+    }
+}
+
+bool Doc::PrepareDrawing(Object *root, bool docWideSteps)
 {
+    PROFILE_STAGE("Doc::PrepareDrawing");
+
+    if (!root) root = this;
+    // Without the document-wide steps, only a measure can be prepared on its own
+    Measure *measure = dynamic_cast<Measure *>(root);
+    assert(docWideSteps || measure);
+
+    ArrayOfObjects objects;
+    ArrayOfObjects::iterator iter;
+
+    // The control events of the measure cannot point to other measures
+    if (!docWideSteps) {
+        std::vector<Measure *> measures(1, measure);
+        InterfaceComparisonAny matchInterface({ INTERFACE_TIME_POINT, INTERFACE_TIME_SPANNING });
+        measure->FindAllChildByAttComparison(&objects, &matchInterface, 1);
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            TimeSpanningInterface *spanningInterface = (*iter)->GetTimeSpanningInterface();
+            TimePointInterface *interface = (*iter)->GetTimePointInterface();
+            assert(interface);
+            if (interface->HasStartid() && !this->IsReferenceInMeasures(interface->GetStartid(), measures)) {
+                return false;
+            }
+            if (!spanningInterface) continue;
+            if (spanningInterface->HasEndid()
+                && !this->IsReferenceInMeasures(spanningInterface->GetEndid(), measures)) {
+                return false;
+            }
+            if (spanningInterface->HasTstamp2() && (spanningInterface->GetTstamp2().first > 0)) return false;
+        }
+    }
+
+    // The ending is not a child of the measure and is kept when the boundaries are not prepared again
+    Ending *ending = (measure) ? measure->GetDrawingEnding() : NULL;
+
     if (m_drawingPreparationDone) {
-        Functor resetDrawing(&Object::ResetDrawing);
-        this->Process(&resetDrawing, NULL);
+        Functor resetDrawing(&Object::ResetDrawing, "ResetDrawing");
+        root->Process(&resetDrawing, NULL);
     }
 
     // Try to match all spanning elements (slur, tie, etc) by processing backwards
     PrepareTimeSpanningParams prepareTimeSpanningParams;
-    Functor prepareTimeSpanning(&Object::PrepareTimeSpanning);
-    Functor prepareTimeSpanningEnd(&Object::PrepareTimeSpanningEnd);
-    this->Process(
+    Functor prepareTimeSpanning(&Object::PrepareTimeSpanning, "PrepareTimeSpanning");
+    Functor prepareTimeSpanningEnd(&Object::PrepareTimeSpanningEnd, "PrepareTimeSpanningEnd");
+    root->Process(
         &prepareTimeSpanning, &prepareTimeSpanningParams, &prepareTimeSpanningEnd, NULL, UNLIMITED_DEPTH, BACKWARD);
 
     // First we try backwards because normally the spanning elements are at the end of
@@ -264,22 +371,28 @@ void Doc::PrepareDrawing()
     // but this time without filling the list (that is only will the remaining elements)
     if (!prepareTimeSpanningParams.m_timeSpanningInterfaces.empty()) {
         prepareTimeSpanningParams.m_fillList = false;
-        this->Process(&prepareTimeSpanning, &prepareTimeSpanningParams);
+        root->Process(&prepareTimeSpanning, &prepareTimeSpanningParams);
     }
 
     // Try to match all time pointing elements (tempo, fermata, etc) by processing backwards
     PrepareTimePointingParams prepareTimePointingParams;
-    Functor prepareTimePointing(&Object::PrepareTimePointing);
-    Functor prepareTimePointingEnd(&Object::PrepareTimePointingEnd);
-    this->Process(
+    Functor prepareTimePointing(&Object::PrepareTimePointing, "PrepareTimePointing");
+    Functor prepareTimePointingEnd(&Object::PrepareTimePointingEnd, "PrepareTimePointingEnd");
+    root->Process(
         &prepareTimePointing, &prepareTimePointingParams, &prepareTimePointingEnd, NULL, UNLIMITED_DEPTH, BACKWARD);
 
     // Now try to match the @tstamp and @tstamp2 attributes.
     PrepareTimestampsParams prepareTimestampsParams;
     prepareTimestampsParams.m_timeSpanningInterfaces = prepareTimeSpanningParams.m_timeSpanningInterfaces;
-    Functor prepareTimestamps(&Object::PrepareTimestamps);
-    Functor prepareTimestampsEnd(&Object::PrepareTimestampsEnd);
-    this->Process(&prepareTimestamps, &prepareTimestampsParams, &prepareTimestampsEnd);
+    Functor prepareTimestamps(&Object::PrepareTimestamps, "PrepareTimestamps");
+    Functor prepareTimestampsEnd(&Object::PrepareTimestampsEnd, "PrepareTimestampsEnd");
+    root->Process(&prepareTimestamps, &prepareTimestampsParams, &prepareTimestampsEnd);
+
+    // Without the document-wide steps, the ones left can point to another measure
+    if (!docWideSteps
+        && (!prepareTimestampsParams.m_timeSpanningInterfaces.empty() || !prepareTimestampsParams.m_tstamps.empty())) {
+        return false;
+    }
 
     // If some are still there, then it is probably an issue in the encoding
     if (!prepareTimestampsParams.m_timeSpanningInterfaces.empty()) {
@@ -289,9 +402,9 @@ void Doc::PrepareDrawing()
 
     // Prepare the cross-staff pointers
     PrepareCrossStaffParams prepareCrossStaffParams;
-    Functor prepareCrossStaff(&Object::PrepareCrossStaff);
-    Functor prepareCrossStaffEnd(&Object::PrepareCrossStaffEnd);
-    this->Process(&prepareCrossStaff, &prepareCrossStaffParams, &prepareCrossStaffEnd);
+    Functor prepareCrossStaff(&Object::PrepareCrossStaff, "PrepareCrossStaff");
+    Functor prepareCrossStaffEnd(&Object::PrepareCrossStaffEnd, "PrepareCrossStaffEnd");
+    root->Process(&prepareCrossStaff, &prepareCrossStaffParams, &prepareCrossStaffEnd);
 
     // We need to populate processing lists for processing the document by Layer (for matching @tie) and
     // by Verse (for matching syllable connectors)
@@ -302,8 +415,8 @@ void Doc::PrepareDrawing()
 
     // We first fill a tree of ints with [staff/layer] and [staff/layer/verse] numbers (@n) to be processed
     // LogElapsedTimeStart();
-    Functor prepareProcessingLists(&Object::PrepareProcessingLists);
-    this->Process(&prepareProcessingLists, &prepareProcessingListsParams);
+    Functor prepareProcessingLists(&Object::PrepareProcessingLists, "PrepareProcessingLists");
+    root->Process(&prepareProcessingLists, &prepareProcessingListsParams);
 
     // The tree is used to process each staff/layer/verse separately
     // For this, we use an array of AttCommmonNComparison that looks for each object if it is of the type
@@ -327,13 +440,15 @@ void Doc::PrepareDrawing()
             filters.push_back(&matchLayer);
 
             PrepareTieAttrParams prepareTieAttrParams;
-            Functor prepareTieAttr(&Object::PrepareTieAttr);
-            Functor prepareTieAttrEnd(&Object::PrepareTieAttrEnd);
-            this->Process(&prepareTieAttr, &prepareTieAttrParams, &prepareTieAttrEnd, &filters);
+            Functor prepareTieAttr(&Object::PrepareTieAttr, "PrepareTieAttr");
+            Functor prepareTieAttrEnd(&Object::PrepareTieAttrEnd, "PrepareTieAttrEnd");
+            root->Process(&prepareTieAttr, &prepareTieAttrParams, &prepareTieAttrEnd, &filters);
 
             // After having processed one layer, we check if we have open ties - if yes, we
             // must reset them and they will be ignored.
             if (!prepareTieAttrParams.m_currentNotes.empty()) {
+                // Without the document-wide steps, the @tie can go to the next measure
+                if (!docWideSteps) return false;
                 std::vector<Note *>::iterator iter;
                 for (iter = prepareTieAttrParams.m_currentNotes.begin();
                      iter != prepareTieAttrParams.m_currentNotes.end(); iter++) {
@@ -355,8 +470,27 @@ void Doc::PrepareDrawing()
             filters.push_back(&matchLayer);
 
             PreparePointersByLayerParams preparePointersByLayerParams;
-            Functor preparePointersByLayer(&Object::PreparePointersByLayer);
-            this->Process(&preparePointersByLayer, &preparePointersByLayerParams, NULL, &filters);
+            Functor preparePointersByLayer(&Object::PreparePointersByLayer, "PreparePointersByLayer");
+            root->Process(&preparePointersByLayer, &preparePointersByLayerParams, NULL, &filters);
+        }
+    }
+
+    // Without the document-wide steps, a @tie median or terminal not matched comes from the previous measure
+    if (!docWideSteps) {
+        AttComparison matchNote(NOTE);
+        root->FindAllChildByAttComparison(&objects, &matchNote);
+        std::set<Object *> tieEnds;
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            Note *note = dynamic_cast<Note *>(*iter);
+            assert(note);
+            if (note->GetDrawingTieAttr()) tieEnds.insert(note->GetDrawingTieAttr()->GetEnd());
+        }
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            Note *note = dynamic_cast<Note *>(*iter);
+            assert(note);
+            AttTiepresent *check = note;
+            if (!note->HasTie() && note->IsChordTone()) check = note->IsChordTone();
+            if (((check->GetTie() == TIE_m) || (check->GetTie() == TIE_t)) && !tieEnds.count(note)) return false;
         }
     }
 
@@ -378,9 +512,11 @@ void Doc::PrepareDrawing()
                 // The first pass sets m_drawingFirstNote and m_drawingLastNote for each syl
                 // m_drawingLastNote is set only if the syl has a forward connector
                 PrepareLyricsParams prepareLyricsParams;
-                Functor prepareLyrics(&Object::PrepareLyrics);
-                Functor prepareLyricsEnd(&Object::PrepareLyricsEnd);
-                this->Process(&prepareLyrics, &prepareLyricsParams, &prepareLyricsEnd, &filters);
+                Functor prepareLyrics(&Object::PrepareLyrics, "PrepareLyrics");
+                Functor prepareLyricsEnd(&Object::PrepareLyricsEnd, "PrepareLyricsEnd");
+                root->Process(&prepareLyrics, &prepareLyricsParams, &prepareLyricsEnd, &filters);
+                // Without the document-wide steps, the syllable connector can go to the next measure
+                if (!docWideSteps && prepareLyricsParams.m_currentSyl) return false;
             }
         }
     }
@@ -389,9 +525,10 @@ void Doc::PrepareDrawing()
     // TimeSpanningInterface to each staff they are extended. This does not need to be done staff by staff because we
     // can just check the staff->GetN to see where we are (see Staff::FillStaffCurrentTimeSpanning)
     FillStaffCurrentTimeSpanningParams fillStaffCurrentTimeSpanningParams;
-    Functor fillStaffCurrentTimeSpanning(&Object::FillStaffCurrentTimeSpanning);
-    Functor fillStaffCurrentTimeSpanningEnd(&Object::FillStaffCurrentTimeSpanningEnd);
-    this->Process(&fillStaffCurrentTimeSpanning, &fillStaffCurrentTimeSpanningParams, &fillStaffCurrentTimeSpanningEnd);
+    Functor fillStaffCurrentTimeSpanning(&Object::FillStaffCurrentTimeSpanning, "FillStaffCurrentTimeSpanning");
+    Functor fillStaffCurrentTimeSpanningEnd(
+        &Object::FillStaffCurrentTimeSpanningEnd, "FillStaffCurrentTimeSpanningEnd");
+    root->Process(&fillStaffCurrentTimeSpanning, &fillStaffCurrentTimeSpanningParams, &fillStaffCurrentTimeSpanningEnd);
 
     // Something must be wrong in the encoding because a TimeSpanningInterface was left open
     if (!fillStaffCurrentTimeSpanningParams.m_timeSpanningElements.empty()) {
@@ -399,40 +536,47 @@ void Doc::PrepareDrawing()
             fillStaffCurrentTimeSpanningParams.m_timeSpanningElements.size());
     }
 
-    // Process by staff for matching mRpt elements and setting the drawing number
-    for (staves = prepareProcessingListsParams.m_layerTree.child.begin();
-         staves != prepareProcessingListsParams.m_layerTree.child.end(); ++staves) {
-        for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
-            filters.clear();
-            // Create ad comparison object for each type / @n
-            AttCommonNComparison matchStaff(STAFF, staves->first);
-            AttCommonNComparison matchLayer(LAYER, layers->first);
-            filters.push_back(&matchStaff);
-            filters.push_back(&matchLayer);
+    // The measure repeats and the boundaries depend on the other measures, the ending of the measure is kept
+    if (!docWideSteps) {
+        measure->SetDrawingEnding(ending);
+    }
+    else {
+        // Process by staff for matching mRpt elements and setting the drawing number
+        for (staves = prepareProcessingListsParams.m_layerTree.child.begin();
+             staves != prepareProcessingListsParams.m_layerTree.child.end(); ++staves) {
+            for (layers = staves->second.child.begin(); layers != staves->second.child.end(); ++layers) {
+                filters.clear();
+                // Create ad comparison object for each type / @n
+                AttCommonNComparison matchStaff(STAFF, staves->first);
+                AttCommonNComparison matchLayer(LAYER, layers->first);
+                filters.push_back(&matchStaff);
+                filters.push_back(&matchLayer);
 
-            // We set multiNumber to NONE for indicated we need to look at the staffDef when reaching the first staff
-            PrepareRptParams prepareRptParams(&m_scoreDef);
-            Functor prepareRpt(&Object::PrepareRpt);
-            this->Process(&prepareRpt, &prepareRptParams, NULL, &filters);
+                // We set multiNumber to NONE for indicated we need to look at the staffDef when reaching the first
+                // staff
+                PrepareRptParams prepareRptParams(&m_scoreDef);
+                Functor prepareRpt(&Object::PrepareRpt, "PrepareRpt");
+                root->Process(&prepareRpt, &prepareRptParams, NULL, &filters);
+            }
         }
-    }
 
-    // Prepare the endings (pointers to the measure after and before the boundaries
-    PrepareBoundariesParams prepareEndingsParams;
-    Functor prepareEndings(&Object::PrepareBoundaries);
-    this->Process(&prepareEndings, &prepareEndingsParams);
+        // Prepare the endings (pointers to the measure after and before the boundaries
+        PrepareBoundariesParams prepareEndingsParams;
+        Functor prepareEndings(&Object::PrepareBoundaries, "PrepareBoundaries");
+        root->Process(&prepareEndings, &prepareEndingsParams);
+    }
 
     // Prepare the floating drawing groups
     PrepareFloatingGrpsParams prepareFloatingGrpsParams;
-    Functor prepareFloatingGrps(&Object::PrepareFloatingGrps);
-    this->Process(&prepareFloatingGrps, &prepareFloatingGrpsParams);
+    Functor prepareFloatingGrps(&Object::PrepareFloatingGrps, "PrepareFloatingGrps");
+    root->Process(&prepareFloatingGrps, &prepareFloatingGrpsParams);
 
-    Functor prepareLayerElementParts(&Object::PrepareLayerElementParts);
-    this->Process(&prepareLayerElementParts, NULL);
+    Functor prepareLayerElementParts(&Object::PrepareLayerElementParts, "PrepareLayerElementParts");
+    root->Process(&prepareLayerElementParts, NULL);
 
     // Prepare the drawing cue size
-    Functor prepareDrawingCueSize(&Object::PrepareDrawingCueSize);
-    this->Process(&prepareDrawingCueSize, NULL);
+    Functor prepareDrawingCueSize(&Object::PrepareDrawingCueSize, "PrepareDrawingCueSize");
+    root->Process(&prepareDrawingCueSize, NULL);
 
     /*
     // Alternate solution with StaffN_LayerN_VerseN_t
@@ -453,7 +597,7 @@ void Doc::PrepareDrawing()
                 filters.push_back(&matchVerse);
 
                 FunctorParams paramsLyrics;
-                Functor prepareLyrics(&Object::PrepareLyrics);
+                Functor prepareLyrics(&Object::PrepareLyrics, "PrepareLyrics");
                 this->Process(&prepareLyrics, paramsLyrics, NULL, &filters);
             }
         }
@@ -462,7 +606,103 @@ void Doc::PrepareDrawing()
 
     // LogElapsedTimeEnd ("Preparing drawing");
 
-    m_drawingPreparationDone = true;
+    if (docWideSteps) m_drawingPreparationDone = true;
+
+    return true;
+}
+
+bool Doc::HasDrawingLinksAcross(const std::vector<Measure *> &measures)
+{
+    if (!m_drawingPreparationDone) return true;
+
+    ArrayOfObjects objects;
+    ArrayOfObjects::iterator iter;
+    std::vector<Measure *>::const_iterator measureIter;
+    for (measureIter = measures.begin(); measureIter != measures.end(); ++measureIter) {
+        Measure *measure = *measureIter;
+
+        // The measure repeats are numbered from one measure to the next, and this in all the readings
+        AttComparison matchMRpt(MRPT);
+        Functor findAllByAttComparison(&Object::FindAllByAttComparison, "FindAllByAttComparison");
+        findAllByAttComparison.m_visibleOnly = false;
+        FindAllByAttComparisonParams findAllByAttComparisonParams(&matchMRpt, &objects);
+        objects.clear();
+        measure->Process(&findAllByAttComparison, &findAllByAttComparisonParams);
+        if (!objects.empty()) return true;
+
+        // The slurs, ties and syllable connectors running from a previous measure
+        AttComparison matchStaff(STAFF);
+        measure->FindAllChildByAttComparison(&objects, &matchStaff, 1);
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            Staff *staff = dynamic_cast<Staff *>(*iter);
+            assert(staff);
+            if (!staff->m_timeSpanningElements.empty()) return true;
+        }
+
+        // The @tie and the syllable connectors going to a next measure
+        AttComparisonAny matchNoteSyl({ NOTE, SYL });
+        measure->FindAllChildByAttComparison(&objects, &matchNoteSyl);
+        for (iter = objects.begin(); iter != objects.end(); ++iter) {
+            TimeSpanningInterface *interface = NULL;
+            if ((*iter)->Is(NOTE)) {
+                Note *note = dynamic_cast<Note *>(*iter);
+                assert(note);
+                interface = note->GetDrawingTieAttr();
+            }
+            else {
+                interface = (*iter)->GetTimeSpanningInterface();
+            }
+            if (interface && interface->IsSpanningMeasures()) return true;
+        }
+    }
+
+    // The control events pointing to the measures or from them to other ones
+    InterfaceComparisonAny matchInterface({ INTERFACE_TIME_POINT, INTERFACE_TIME_SPANNING });
+    this->FindAllChildByAttComparison(&objects, &matchInterface, 4);
+    for (iter = objects.begin(); iter != objects.end(); ++iter) {
+        TimeSpanningInterface *spanningInterface = (*iter)->GetTimeSpanningInterface();
+        TimePointInterface *interface = (*iter)->GetTimePointInterface();
+        assert(interface);
+        Measure *measure = dynamic_cast<Measure *>((*iter)->GetFirstParent(MEASURE));
+        Measure *startMeasure = interface->GetStartMeasure();
+        Measure *endMeasure = (spanningInterface) ? spanningInterface->GetEndMeasure() : startMeasure;
+        if (std::find(measures.begin(), measures.end(), measure) != measures.end()) {
+            if ((startMeasure && (startMeasure != measure)) || (endMeasure && (endMeasure != measure))) return true;
+            continue;
+        }
+        if (std::find(measures.begin(), measures.end(), startMeasure) != measures.end()) return true;
+        if (std::find(measures.begin(), measures.end(), endMeasure) != measures.end()) return true;
+        // The ones not matched can point to a reading that is not visible
+        if (!interface->GetStart() && interface->HasStartid()
+            && this->IsReferenceInMeasures(interface->GetStartid(), measures)) {
+            return true;
+        }
+        if (spanningInterface && !spanningInterface->GetEnd() && spanningInterface->HasEndid()
+            && this->IsReferenceInMeasures(spanningInterface->GetEndid(), measures)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Doc::IsReferenceInMeasures(const std::string &reference, const std::vector<Measure *> &measures)
+{
+    // Only the fragment of the reference is the @xml:id (see TimePointInterface::ExtractUuidFragment)
+    std::string uuid = reference;
+    size_t pos = reference.find_last_of("#");
+    if ((pos != std::string::npos) && (pos < reference.length() - 1)) uuid = reference.substr(pos + 1);
+
+    Functor findByUuid(&Object::FindByUuid, "FindByUuid");
+    findByUuid.m_visibleOnly = false;
+    std::vector<Measure *>::const_iterator iter;
+    for (iter = measures.begin(); iter != measures.end(); ++iter) {
+        FindByUuidParams findByUuidParams;
+        findByUuidParams.m_uuid = uuid;
+        (*iter)->Process(&findByUuid, &findByUuidParams);
+        if (findByUuidParams.m_element) return true;
+    }
+    return false;
 }
 
 void Doc::CollectScoreDefs(bool force)
@@ -472,13 +712,13 @@ void Doc::CollectScoreDefs(bool force)
     }
 
     if (m_currentScoreDefDone) {
-        Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef);
+        Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef, "UnsetCurrentScoreDef");
         this->Process(&unsetCurrentScoreDef, NULL);
     }
 
     ScoreDef upcomingScoreDef = m_scoreDef;
     SetCurrentScoreDefParams setCurrentScoreDefParams(this, &upcomingScoreDef);
-    Functor setCurrentScoreDef(&Object::SetCurrentScoreDef);
+    Functor setCurrentScoreDef(&Object::SetCurrentScoreDef, "SetCurrentScoreDef");
 
     // First process the current scoreDef in order to fill the staffDef with
     // the appropriate drawing values
@@ -491,13 +731,48 @@ void Doc::CollectScoreDefs(bool force)
     m_currentScoreDefDone = true;
 }
 
+void Doc::CollectScoreDefsFromPage(int pageIdx)
+{
+    if (pageIdx == 0) {
+        this->CollectScoreDefs(true);
+        return;
+    }
+
+    Page *page = dynamic_cast<Page *>(this->GetChild(pageIdx));
+    assert(page);
+
+    // Start with the scoreDef of the page as it was set by the previous call
+    ScoreDef upcomingScoreDef = page->m_drawingScoreDef;
+    // Cautionary values have already been set to the previous measure
+    upcomingScoreDef.m_setAsDrawing = false;
+    SetCurrentScoreDefParams setCurrentScoreDefParams(this, &upcomingScoreDef);
+    setCurrentScoreDefParams.m_previousMeasure
+        = dynamic_cast<Measure *>(this->GetChild(pageIdx - 1)->FindChildByType(MEASURE, UNLIMITED_DEPTH, BACKWARD));
+
+    Functor unsetCurrentScoreDef(&Object::UnsetCurrentScoreDef, "UnsetCurrentScoreDef");
+    Functor setCurrentScoreDef(&Object::SetCurrentScoreDef, "SetCurrentScoreDef");
+    int i;
+    for (i = pageIdx; i < this->GetChildCount(); i++) {
+        this->GetChild(i)->Process(&unsetCurrentScoreDef, NULL);
+    }
+    for (i = pageIdx; i < this->GetChildCount(); i++) {
+        this->GetChild(i)->Process(&setCurrentScoreDef, &setCurrentScoreDefParams);
+    }
+
+    m_currentScoreDefDone = true;
+}
+
 void Doc::CastOffDoc()
 {
+    PROFILE_STAGE("Doc::CastOffDoc");
+
     this->CollectScoreDefs();
 
     Page *contentPage = this->SetDrawingPage(0);
     assert(contentPage);
-    contentPage->LayOutHorizontally();
+    // Kept for casting off the document again from one of its pages (see Doc::CastOffDocFrom)
+    m_castOffLongestActualDur = this->GetLongestActualDur();
+    contentPage->LayOutHorizontally(m_castOffLongestActualDur);
 
     System *contentSystem = dynamic_cast<System *>(contentPage->DetachChild(0));
     assert(contentSystem);
@@ -510,9 +785,10 @@ void Doc::CastOffDoc()
     castOffSystemsParams.m_shift = -contentSystem->GetDrawingLabelsWidth();
     castOffSystemsParams.m_currentScoreDefWidth
         = contentPage->m_drawingScoreDef.GetDrawingWidth() + contentSystem->GetDrawingAbbrLabelsWidth();
+    currentSystem->m_castOffScoreDefWidth = castOffSystemsParams.m_currentScoreDefWidth;
 
-    Functor castOffSystems(&Object::CastOffSystems);
-    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd);
+    Functor castOffSystems(&Object::CastOffSystems, "CastOffSystems");
+    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd, "CastOffSystemsEnd");
     contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
     delete contentSystem;
 
@@ -534,7 +810,7 @@ void Doc::CastOffDoc()
     CastOffPagesParams castOffPagesParams(contentPage, this, currentPage);
     castOffPagesParams.m_pageHeight
         = this->m_drawingPageHeight - this->m_drawingPageTopMar; // obviously we need a bottom margin
-    Functor castOffPages(&Object::CastOffPages);
+    Functor castOffPages(&Object::CastOffPages, "CastOffPages");
     contentPage->Process(&castOffPages, &castOffPagesParams);
     delete contentPage;
 
@@ -546,6 +822,246 @@ void Doc::CastOffDoc()
     this->CollectScoreDefs(true);
 }
 
+void Doc::CastOffDocIncrementally()
+{
+    PROFILE_STAGE("Doc::CastOffDocIncrementally");
+
+    this->CollectScoreDefs();
+
+    // The content page becomes the pending page from which the content is cast off chunk by chunk
+    m_castOffPendingPage = dynamic_cast<Page *>(this->GetChild(0));
+    assert(m_castOffPendingPage);
+    // Start with a small chunk, it will be adjusted to the number of measures per page
+    m_castOffChunkSize = 16;
+    m_castOffScoreDefWidth = 0;
+
+    // Each chunk has to be laid out with the longest duration of the entire content, as in Doc::CastOffDoc
+    m_castOffLongestActualDur = this->GetLongestActualDur();
+
+    this->CastOffPendingPages(0);
+}
+
+bool Doc::CastOffDocFrom(Page *page, bool incrementally)
+{
+    assert(page && (page->GetParent() == this));
+
+    // The pages before are kept only if the content is still laid out as when they were cast off
+    if ((m_castOffLongestActualDur == VRV_UNSET) || (this->GetLongestActualDur() != m_castOffLongestActualDur)) {
+        return false;
+    }
+
+    System *firstSystem = dynamic_cast<System *>(page->FindChildByType(SYSTEM, 1));
+    if (!firstSystem) return false;
+    // The pending system was not cast off and the pending page starts with it only if it is the first of its chunk
+    int scoreDefWidth = ((page == m_castOffPendingPage) && (page->GetChildCount() == 1))
+        ? m_castOffScoreDefWidth
+        : firstSystem->m_castOffScoreDefWidth;
+    int pageIdx = page->GetIdx();
+
+    // Move the content of the page and of the following ones to a new pending page
+    Page *pendingPage = new Page();
+    System *pendingSystem = new System();
+    pendingPage->AddChild(pendingSystem);
+
+    UnCastOffParams unCastOffParams(pendingSystem);
+    Functor unCastOff(&Object::UnCastOff, "UnCastOff");
+    int i;
+    for (i = pageIdx; i < this->GetChildCount(); i++) {
+        this->GetChild(i)->Process(&unCastOff, &unCastOffParams);
+    }
+    while (this->GetChildCount() > pageIdx) {
+        delete this->DetachChild(pageIdx);
+    }
+
+    // The content is then cast off chunk by chunk as in Doc::CastOffDocIncrementally
+    m_castOffPendingPage = pendingPage;
+    this->AddChild(m_castOffPendingPage);
+    m_castOffChunkSize = 16;
+    m_castOffScoreDefWidth = scoreDefWidth;
+    this->ResetDrawingPage();
+
+    if (!incrementally) this->CastOffPendingPages();
+
+    return true;
+}
+
+void Doc::CastOffPendingPages(int pageIdx)
+{
+    if (!m_castOffPendingPage) return;
+
+    // Pages before the pending page are not changed, so we can keep the drawing page if it is one of them
+    int drawingPageIdx = (m_drawingPage && (m_drawingPage != m_castOffPendingPage)) ? m_drawingPage->GetIdx() : -1;
+
+    // All the pages before the pending page are complete
+    while (m_castOffPendingPage && ((pageIdx == -1) || (pageIdx >= m_castOffPendingPage->GetIdx()))) {
+        this->CastOffPendingChunk();
+    }
+
+    this->ResetDrawingPage();
+    if (drawingPageIdx != -1) this->SetDrawingPage(drawingPageIdx);
+}
+
+void Doc::CastOffPendingPagesTo(Object *object)
+{
+    assert(object);
+
+    Page *page = dynamic_cast<Page *>(object->GetFirstParent(PAGE));
+    while (page && (page == m_castOffPendingPage)) {
+        this->CastOffPendingPages(page->GetIdx());
+        page = dynamic_cast<Page *>(object->GetFirstParent(PAGE));
+    }
+}
+
+void Doc::CastOffPendingChunk()
+{
+    assert(m_castOffPendingPage);
+
+    int i;
+    int pageCount = this->GetChildCount() - 1;
+    // Systems of the last incomplete page of the previous chunk
+    int systemCount = m_castOffPendingPage->GetChildCount() - 1;
+    bool isFirstChunk = ((pageCount == 0) && (systemCount == 0));
+
+    // Detach the pending page - the chunk is cast off as if it was the end of the document
+    this->DetachChild(pageCount);
+    System *pendingSystem = dynamic_cast<System *>(m_castOffPendingPage->GetLast());
+    assert(pendingSystem);
+
+    // Move the next chunk of content to a content page
+    Page *contentPage = new Page();
+    System *contentSystem = new System();
+    contentPage->AddChild(contentSystem);
+    int childCount = std::min(m_castOffChunkSize, pendingSystem->GetChildCount());
+    for (i = 0; i < childCount; i++) {
+        contentSystem->AddChild(pendingSystem->DetachChild(0));
+    }
+    this->AddChild(contentPage);
+
+    // Only the last page cast off and the content page need their scoreDefs to be collected again
+    int firstPageIdx = std::max(0, pageCount - 1);
+    this->CollectScoreDefsFromPage(firstPageIdx);
+    this->ResetDrawingPage();
+    this->SetDrawingPage(pageCount);
+    contentPage->LayOutHorizontally(m_castOffLongestActualDur);
+
+    contentPage->DetachChild(0);
+    System *currentSystem = new System();
+    contentPage->AddChild(currentSystem);
+    CastOffSystemsParams castOffSystemsParams(contentSystem, contentPage, currentSystem);
+    castOffSystemsParams.m_systemWidth = this->m_drawingPageWidth - this->m_drawingPageLeftMar
+        - this->m_drawingPageRightMar - currentSystem->m_systemLeftMar - currentSystem->m_systemRightMar;
+    // Only the first system of the document has the full labels
+    if (isFirstChunk) {
+        castOffSystemsParams.m_shift = -contentSystem->GetDrawingLabelsWidth();
+        castOffSystemsParams.m_currentScoreDefWidth
+            = contentPage->m_drawingScoreDef.GetDrawingWidth() + contentSystem->GetDrawingAbbrLabelsWidth();
+    }
+    else {
+        // The first measure of the chunk includes the scoreDef drawn at the beginning of the system, which is already
+        // taken into account by the current scoreDef width
+        Measure *firstMeasure = dynamic_cast<Measure *>(contentSystem->FindChildByType(MEASURE, 1));
+        if (firstMeasure) castOffSystemsParams.m_shift = firstMeasure->GetLeftBarLineXRel();
+        castOffSystemsParams.m_currentScoreDefWidth = m_castOffScoreDefWidth;
+    }
+    currentSystem->m_castOffScoreDefWidth = castOffSystemsParams.m_currentScoreDefWidth;
+
+    Functor castOffSystems(&Object::CastOffSystems, "CastOffSystems");
+    Functor castOffSystemsEnd(&Object::CastOffSystemsEnd, "CastOffSystemsEnd");
+    contentSystem->Process(&castOffSystems, &castOffSystemsParams, &castOffSystemsEnd);
+    delete contentSystem;
+    m_castOffScoreDefWidth = castOffSystemsParams.m_currentScoreDefWidth;
+
+    // The last system is cut by the end of the chunk - move its content back to the pending system
+    if (pendingSystem->GetChildCount() > 0) {
+        System *lastSystem = dynamic_cast<System *>(contentPage->DetachChild(contentPage->GetChildCount() - 1));
+        assert(lastSystem);
+        pendingSystem->MoveChildrenFrom(lastSystem, 0);
+        delete lastSystem;
+    }
+
+    // Add the systems of the last page of the previous chunk at the beginning of the content page
+    for (i = 0; i < systemCount; i++) {
+        Object *system = m_castOffPendingPage->DetachChild(0);
+        system->SetParent(contentPage);
+        contentPage->InsertChild(system, i);
+    }
+
+    if (contentPage->GetChildCount() > 0) {
+        // Reset the scoreDef at the beginning of each system
+        this->CollectScoreDefsFromPage(firstPageIdx);
+
+        contentPage->LayOutVertically();
+
+        this->DetachChild(pageCount);
+        assert(contentPage && !contentPage->GetParent());
+
+        Page *currentPage = new Page();
+        this->AddChild(currentPage);
+        CastOffPagesParams castOffPagesParams(contentPage, this, currentPage);
+        castOffPagesParams.m_pageHeight = this->m_drawingPageHeight - this->m_drawingPageTopMar;
+        Functor castOffPages(&Object::CastOffPages, "CastOffPages");
+        contentPage->Process(&castOffPages, &castOffPagesParams);
+    }
+    else {
+        this->DetachChild(pageCount);
+    }
+    delete contentPage;
+
+    // The pending page is still detached and not processed
+    this->CollectScoreDefsFromPage(firstPageIdx);
+    // The page before the chunk may have been laid out already, but its scoreDefs have been created again
+    if (pageCount > 0) {
+        Page *previousPage = dynamic_cast<Page *>(this->GetChild(pageCount - 1));
+        assert(previousPage);
+        previousPage->ResetLayout();
+    }
+
+    if (pendingSystem->GetChildCount() == 0) {
+        // Everything has been cast off
+        delete m_castOffPendingPage;
+        m_castOffPendingPage = NULL;
+    }
+    else {
+        // The last page can still be filled by the next chunk - move its systems back to the pending page
+        if (this->GetChildCount() > pageCount) {
+            Page *lastPage = dynamic_cast<Page *>(this->DetachChild(this->GetChildCount() - 1));
+            assert(lastPage);
+            m_castOffPendingPage->MoveChildrenFrom(lastPage, 0);
+            delete lastPage;
+        }
+        // Make the chunk bigger if no page was completed, otherwise adjust it to the children per page
+        if (this->GetChildCount() == pageCount) {
+            m_castOffChunkSize *= 2;
+        }
+        else {
+            int j;
+            int doneChildCount = 0;
+            for (i = 0; i < this->GetChildCount(); i++) {
+                Object *page = this->GetChild(i);
+                for (j = 0; j < page->GetChildCount(); j++) {
+                    doneChildCount += page->GetChild(j)->GetChildCount();
+                }
+            }
+            int childrenPerPage = doneChildCount / this->GetChildCount();
+            m_castOffChunkSize = std::max(m_castOffChunkSize, childrenPerPage + childrenPerPage / 2);
+        }
+        this->AddChild(m_castOffPendingPage);
+    }
+
+    this->ResetDrawingPage();
+}
+
+int Doc::GetLongestActualDur()
+{
+    AttDurExtreme durExtremeComparison(LONGEST);
+    Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
+    if (!longestDur) return DUR_4;
+
+    DurationInterface *interface = longestDur->GetDurationInterface();
+    assert(interface);
+    return interface->GetActualDur();
+}
+
 void Doc::UnCastOffDoc()
 {
     Page *contentPage = new Page();
@@ -554,10 +1070,12 @@ void Doc::UnCastOffDoc()
 
     UnCastOffParams unCastOffParams(contentSystem);
 
-    Functor unCastOff(&Object::UnCastOff);
+    Functor unCastOff(&Object::UnCastOff, "UnCastOff");
     this->Process(&unCastOff, &unCastOffParams);
 
     this->ClearChildren();
+    m_castOffPendingPage = NULL;
+    m_castOffLongestActualDur = VRV_UNSET;
 
     this->AddChild(contentPage);
 
@@ -569,8 +1087,45 @@ void Doc::UnCastOffDoc()
     this->CollectScoreDefs(true);
 }
 
+void Doc::CastOffPagesDoc()
+{
+    assert(!m_castOffPendingPage);
+
+    // Move all the systems to a content page
+    Page *contentPage = new Page();
+    int i;
+    for (i = 0; i < this->GetChildCount(); i++) {
+        contentPage->MoveChildrenFrom(this->GetChild(i));
+    }
+    this->ClearChildren();
+    this->AddChild(contentPage);
+
+    this->ResetDrawingPage();
+    this->CollectScoreDefs(true);
+    this->SetDrawingPage(0);
+
+    // From here this is the same as in Doc::CastOffDoc, but without redoing the horizontal layout and the systems
+    contentPage->LayOutVertically();
+
+    this->DetachChild(0);
+    assert(contentPage && !contentPage->GetParent());
+
+    Page *currentPage = new Page();
+    this->AddChild(currentPage);
+    CastOffPagesParams castOffPagesParams(contentPage, this, currentPage);
+    castOffPagesParams.m_pageHeight = this->m_drawingPageHeight - this->m_drawingPageTopMar;
+    Functor castOffPages(&Object::CastOffPages, "CastOffPages");
+    contentPage->Process(&castOffPages, &castOffPagesParams);
+    delete contentPage;
+
+    this->ResetDrawingPage();
+    this->CollectScoreDefs(true);
+}
+
 void Doc::CastOffEncodingDoc()
 {
+    PROFILE_STAGE("Doc::CastOffEncodingDoc");
+
     this->CollectScoreDefs();
 
     Page *contentPage = this->SetDrawingPage(0);
@@ -590,7 +1145,7 @@ void Doc::CastOffEncodingDoc()
 
     CastOffEncodingParams castOffEncodingParams(this, page, system, contentSystem);
 
-    Functor castOffEncoding(&Object::CastOffEncoding);
+    Functor castOffEncoding(&Object::CastOffEncoding, "CastOffEncoding");
     contentSystem->Process(&castOffEncoding, &castOffEncodingParams);
     delete contentPage;
 
@@ -600,6 +1155,68 @@ void Doc::CastOffEncodingDoc()
     this->CollectScoreDefs(true);
 }
 
+bool Doc::CastOffLayoutDoc(const std::vector<int> &systemsPerPage, const std::vector<int> &childrenPerSystem,
+    const std::vector<std::string> &pageUuids, const std::vector<std::string> &systemUuids)
+{
+    if (this->GetChildCount() != 1) return false;
+
+    Page *contentPage = dynamic_cast<Page *>(this->GetChild(0));
+    assert(contentPage);
+    if (contentPage->GetChildCount() != 1) return false;
+
+    System *contentSystem = dynamic_cast<System *>(contentPage->GetChild(0));
+    if (!contentSystem) return false;
+
+    // Check that the layout covers exactly the content of the system
+    int systemCount = 0;
+    std::vector<int>::const_iterator iter;
+    for (iter = systemsPerPage.begin(); iter != systemsPerPage.end(); iter++) {
+        if (*iter < 1) return false;
+        systemCount += (*iter);
+    }
+    if (systemCount != (int)childrenPerSystem.size()) return false;
+    int childCount = 0;
+    for (iter = childrenPerSystem.begin(); iter != childrenPerSystem.end(); iter++) {
+        if (*iter < 1) return false;
+        childCount += (*iter);
+    }
+    if (childCount != contentSystem->GetChildCount()) return false;
+
+    this->CollectScoreDefs();
+
+    // Detach the contentPage
+    this->DetachChild(0);
+    assert(contentPage && !contentPage->GetParent());
+
+    int systemIdx = 0;
+    int childIdx = 0;
+    int i, j, k;
+    for (i = 0; i < (int)systemsPerPage.size(); i++) {
+        Page *page = new Page();
+        if (i < (int)pageUuids.size()) page->SetUuid(pageUuids.at(i));
+        this->AddChild(page);
+        for (j = 0; j < systemsPerPage.at(i); j++) {
+            System *system = new System();
+            if (systemIdx < (int)systemUuids.size()) system->SetUuid(systemUuids.at(systemIdx));
+            page->AddChild(system);
+            for (k = 0; k < childrenPerSystem.at(systemIdx); k++) {
+                // Relinquished children stay in the content system until it is deleted
+                system->AddChild(contentSystem->Relinquish(childIdx));
+                childIdx++;
+            }
+            systemIdx++;
+        }
+    }
+    delete contentPage;
+
+    // We need to reset the drawing page to NULL
+    // because idx will still be 0 but contentPage is dead!
+    this->ResetDrawingPage();
+    this->CollectScoreDefs(true);
+
+    return true;
+}
+
 void Doc::ConvertToPageBasedDoc()
 {
     assert(m_scoreBuffer); // Doc::CreateScoreBuffer needs to be called first;
@@ -609,8 +1226,8 @@ void Doc::ConvertToPageBasedDoc()
     page->AddChild(system);
 
     ConvertToPageBasedParams convertToPageBasedParams(system);
-    Functor convertToPageBased(&Object::ConvertToPageBased);
-    Functor convertToPageBasedEnd(&Object::ConvertToPageBasedEnd);
+    Functor convertToPageBased(&Object::ConvertToPageBased, "ConvertToPageBased");
+    Functor convertToPageBasedEnd(&Object::ConvertToPageBasedEnd, "ConvertToPageBasedEnd");
     m_scoreBuffer->Process(&convertToPageBased, &convertToPageBasedParams, &convertToPageBasedEnd);
 
     m_scoreBuffer->ClearRelinquishedChildren();
@@ -634,31 +1251,119 @@ int Doc::GetPageCount() const
     return GetChildCount();
 }
 
+int Doc::GetEstimatedPageCount() const
+{
+    if (!m_castOffPendingPage) return this->GetPageCount();
+
+    int pageCount = this->GetPageCount() - 1;
+    int doneChildCount = 0;
+    int pendingChildCount = 0;
+    int i, j;
+    for (i = 0; i < this->GetChildCount(); i++) {
+        Object *page = this->GetChild(i);
+        for (j = 0; j < page->GetChildCount(); j++) {
+            if (page == m_castOffPendingPage)
+                pendingChildCount += page->GetChild(j)->GetChildCount();
+            else
+                doneChildCount += page->GetChild(j)->GetChildCount();
+        }
+    }
+    if (doneChildCount == 0) return pageCount + 1;
+
+    // Round up the pending pages, the pending page has at least one page
+    int pendingPageCount = (pendingChildCount * pageCount + doneChildCount - 1) / doneChildCount;
+    return pageCount + std::max(1, pendingPageCount);
+}
+
 bool Doc::GetMidiExportDone() const
 {
     return m_midiExportDone;
 }
 
+void Doc::UpdateGlyphMetrics()
+{
+    assert(m_musicFont);
+
+    if ((m_glyphMetricsFontSize == m_drawingSmuflFontSize) && (m_glyphMetricsFont == m_musicFont)) {
+        return;
+    }
+
+    int size = 2 * (SMUFL_LAST_CODE - SMUFL_FIRST_CODE + 1);
+    m_glyphWidths.assign(size, VRV_UNSET);
+    m_glyphHeights.assign(size, VRV_UNSET);
+    m_glyphDescenders.assign(size, VRV_UNSET);
+
+    int i, j;
+    for (i = 0; i <= SMUFL_LAST_CODE - SMUFL_FIRST_CODE; i++) {
+        Glyph *glyph = m_musicFont->GetGlyph(SMUFL_FIRST_CODE + i);
+        if (!glyph) continue;
+        int x, y, w, h;
+        glyph->GetBoundingBox(x, y, w, h);
+        w = w * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        h = h * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        y = y * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        // Normal size first and then grace size
+        for (j = 0; j < 2; j++) {
+            if (j == 1) {
+                w = w * this->m_style->m_graceNum / this->m_style->m_graceDen;
+                h = h * this->m_style->m_graceNum / this->m_style->m_graceDen;
+                y = y * this->m_style->m_graceNum / this->m_style->m_graceDen;
+            }
+            m_glyphWidths.at(2 * i + j) = w;
+            m_glyphHeights.at(2 * i + j) = h;
+            m_glyphDescenders.at(2 * i + j) = y;
+        }
+    }
+
+    m_glyphMetricsFontSize = m_drawingSmuflFontSize;
+    m_glyphMetricsFont = m_musicFont;
+}
+
+int Doc::GetGlyphMetricsIdx(wchar_t code, bool graceSize) const
+{
+    if ((code < SMUFL_FIRST_CODE) || (code > SMUFL_LAST_CODE)) return VRV_UNSET;
+    // The metrics are not calculated yet or for another font or font size
+    if ((m_glyphMetricsFont != m_musicFont) || (m_glyphMetricsFontSize != m_drawingSmuflFontSize)) return VRV_UNSET;
+
+    int idx = 2 * (code - SMUFL_FIRST_CODE) + (graceSize ? 1 : 0);
+    if ((idx >= (int)m_glyphWidths.size()) || (m_glyphWidths[idx] == VRV_UNSET)) return VRV_UNSET;
+    return idx;
+}
+
 int Doc::GetGlyphHeight(wchar_t code, int staffSize, bool graceSize) const
 {
-    int x, y, w, h;
-    Glyph *glyph = Resources::GetGlyph(code);
-    assert(glyph);
-    glyph->GetBoundingBox(x, y, w, h);
-    h = h * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
-    if (graceSize) h = h * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    int h;
+    int idx = this->GetGlyphMetricsIdx(code, graceSize);
+    if (idx != VRV_UNSET) {
+        h = m_glyphHeights[idx];
+    }
+    else {
+        int x, y, w;
+        Glyph *glyph = m_musicFont->GetGlyph(code);
+        assert(glyph);
+        glyph->GetBoundingBox(x, y, w, h);
+        h = h * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        if (graceSize) h = h * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    }
     h = h * staffSize / 100;
     return h;
 }
 
 int Doc::GetGlyphWidth(wchar_t code, int staffSize, bool graceSize) const
 {
-    int x, y, w, h;
-    Glyph *glyph = Resources::GetGlyph(code);
-    assert(glyph);
-    glyph->GetBoundingBox(x, y, w, h);
-    w = w * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
-    if (graceSize) w = w * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    int w;
+    int idx = this->GetGlyphMetricsIdx(code, graceSize);
+    if (idx != VRV_UNSET) {
+        w = m_glyphWidths[idx];
+    }
+    else {
+        int x, y, h;
+        Glyph *glyph = m_musicFont->GetGlyph(code);
+        assert(glyph);
+        glyph->GetBoundingBox(x, y, w, h);
+        w = w * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        if (graceSize) w = w * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    }
     w = w * staffSize / 100;
     return w;
 }
@@ -683,12 +1388,19 @@ Point Doc::ConvertFontPoint(const Glyph *glyph, const Point &fontPoint, int staf
 
 int Doc::GetGlyphDescender(wchar_t code, int staffSize, bool graceSize) const
 {
-    int x, y, w, h;
-    Glyph *glyph = Resources::GetGlyph(code);
-    assert(glyph);
-    glyph->GetBoundingBox(x, y, w, h);
-    y = y * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
-    if (graceSize) y = y * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    int y;
+    int idx = this->GetGlyphMetricsIdx(code, graceSize);
+    if (idx != VRV_UNSET) {
+        y = m_glyphDescenders[idx];
+    }
+    else {
+        int x, w, h;
+        Glyph *glyph = m_musicFont->GetGlyph(code);
+        assert(glyph);
+        glyph->GetBoundingBox(x, y, w, h);
+        y = y * m_drawingSmuflFontSize / glyph->GetUnitsPerEm();
+        if (graceSize) y = y * this->m_style->m_graceNum / this->m_style->m_graceDen;
+    }
     y = y * staffSize / 100;
     return y;
 }
@@ -698,7 +1410,7 @@ int Doc::GetTextGlyphHeight(wchar_t code, FontInfo *font, bool graceSize) const
     assert(font);
 
     int x, y, w, h;
-    Glyph *glyph = Resources::GetTextGlyph(code);
+    Glyph *glyph = Resources::GetTextGlyph(code, Resources::GetTextFontVariant(font));
     assert(glyph);
     glyph->GetBoundingBox(x, y, w, h);
     h = h * font->GetPointSize() / glyph->GetUnitsPerEm();
@@ -711,7 +1423,7 @@ int Doc::GetTextGlyphWidth(wchar_t code, FontInfo *font, bool graceSize) const
     assert(font);
 
     int x, y, w, h;
-    Glyph *glyph = Resources::GetTextGlyph(code);
+    Glyph *glyph = Resources::GetTextGlyph(code, Resources::GetTextFontVariant(font));
     assert(glyph);
     glyph->GetBoundingBox(x, y, w, h);
     w = w * font->GetPointSize() / glyph->GetUnitsPerEm();
@@ -724,7 +1436,7 @@ int Doc::GetTextGlyphDescender(wchar_t code, FontInfo *font, bool graceSize) con
     assert(font);
 
     int x, y, w, h;
-    Glyph *glyph = Resources::GetTextGlyph(code);
+    Glyph *glyph = Resources::GetTextGlyph(code, Resources::GetTextFontVariant(font));
     assert(glyph);
     glyph->GetBoundingBox(x, y, w, h);
     y = y * font->GetPointSize() / glyph->GetUnitsPerEm();
@@ -815,19 +1527,29 @@ int Doc::GetCueSize(int value) const
 }
 
 FontInfo *Doc::GetDrawingSmuflFont(int staffSize, bool graceSize)
+{
+    m_drawingSmuflFont.SetPointSize(GetDrawingSmuflFontSize(staffSize, graceSize));
+    return &m_drawingSmuflFont;
+}
+
+int Doc::GetDrawingSmuflFontSize(int staffSize, bool graceSize) const
 {
     int value = m_drawingSmuflFontSize * staffSize / 100;
     if (graceSize) value = value * this->m_style->m_graceNum / this->m_style->m_graceDen;
-    m_drawingSmuflFont.SetPointSize(value);
-    return &m_drawingSmuflFont;
+    return value;
 }
 
 FontInfo *Doc::GetDrawingLyricFont(int staffSize)
 {
-    m_drawingLyricFont.SetPointSize(m_drawingLyricFontSize * staffSize / 100);
+    m_drawingLyricFont.SetPointSize(GetDrawingLyricFontSize(staffSize));
     return &m_drawingLyricFont;
 }
 
+int Doc::GetDrawingLyricFontSize(int staffSize) const
+{
+    return m_drawingLyricFontSize * staffSize / 100;
+}
+
 char Doc::GetLeftMargin(const ClassId classId) const
 {
     if (classId == ACCID) return m_style->m_leftMarginAccid;
@@ -993,6 +1715,7 @@ Page *Doc::SetDrawingPage(int pageIdx)
 
     // values for fonts
     m_drawingSmuflFontSize = CalcMusicFontSize();
+    this->UpdateGlyphMetrics();
     m_drawingLyricFontSize = m_drawingUnit * m_style->m_lyricSize / PARAM_DENOMINATOR;
 
     glyph_size = GetGlyphWidth(SMUFL_E0A3_noteheadHalf, 100, 0);
@@ -64,6 +64,22 @@ EditorialElement::~EditorialElement()
 {
 }
 
+bool EditorialElement::SetVisibleChild(EditorialElement *child)
+{
+    bool changed = false;
+    ArrayOfObjects::iterator iter;
+    for (iter = m_children.begin(); iter != m_children.end(); ++iter) {
+        EditorialElement *current = dynamic_cast<EditorialElement *>(*iter);
+        if (!current) continue;
+        VisibilityType visibility = (current == child) ? Visible : Hidden;
+        if (current->m_visibility != visibility) {
+            current->m_visibility = visibility;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
 void EditorialElement::AddChild(Object *child)
 {
     if (child->IsEditorialElement()) {
@@ -19,6 +19,7 @@
 #include "scoredef.h"
 #include "section.h"
 #include "system.h"
+#include "timemap.h"
 #include "vrv.h"
 
 namespace vrv {
@@ -162,4 +163,16 @@ int Ending::PrepareFloatingGrps(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Ending::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    // The content of the ending is between the ending milestone and its end
+    if (this->IsBoundary()) params->m_timemap->StartSection(this->GetUuid());
+
+    return FUNCTOR_CONTINUE;
+}
+
 } // namespace vrv
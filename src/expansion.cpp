@@ -13,6 +13,9 @@
 
 //----------------------------------------------------------------------------
 
+#include "functorparams.h"
+#include "timemap.h"
+
 namespace vrv {
 
 //----------------------------------------------------------------------------
@@ -42,4 +45,15 @@ void Expansion::Reset()
 // Expansion functor methods
 //----------------------------------------------------------------------------
 
+int Expansion::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    params->m_timemap->AddExpansion(this->GetPlist());
+
+    return FUNCTOR_CONTINUE;
+}
+
 } // namespace vrv
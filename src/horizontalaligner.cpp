@@ -528,7 +528,7 @@ bool Alignment::IsOfType(const std::vector<AlignmentType> &types)
 
 void Alignment::GetLeftRight(int staffN, int &minLeft, int &maxRight)
 {
-    Functor getAlignmentLeftRight(&Object::GetAlignmentLeftRight);
+    Functor getAlignmentLeftRight(&Object::GetAlignmentLeftRight, "GetAlignmentLeftRight");
     GetAlignmentLeftRightParams getAlignmentLeftRightParams(&getAlignmentLeftRight);
 
     if (staffN != VRV_UNSET) {
@@ -438,12 +438,8 @@ bool HumdrumInput::convertHumdrum(void)
 {
     hum::HumdrumFile &infile = m_infile;
 
-    if (GetOutputFormat() == "humdrum") {
-        // allow for filtering in toolkit.
-        return true;
-    }
-
     // apply Humdrum tools if there are any filters in the file.
+    // This is also done for the Humdrum output, which the toolkit takes from the filtered file.
     if (infile.hasFilters()) {
         hum::Tool_filter filter;
         filter.run(infile);
@@ -459,6 +455,10 @@ bool HumdrumInput::convertHumdrum(void)
         }
     }
 
+    if (GetOutputFormat() == "humdrum") {
+        return true;
+    }
+
     m_multirest = analyzeMultiRest(infile);
 
     infile.analyzeKernSlurs();
@@ -6748,7 +6748,20 @@ static const EntityNameEntry StaticEntityNames[] = {
 
 typedef std::map<std::string, unsigned int> EntityNameMap;
 typedef std::pair<std::string, unsigned int> EntityNamePair;
-static EntityNameMap EntityNames;
+
+// Loaded once from StaticEntityNames when the library is loaded and read-only afterwards,
+// so that several files can be imported concurrently
+static EntityNameMap LoadEntityNames()
+{
+    EntityNameMap names;
+    const EntityNameEntry *ThisEntry;
+    for (ThisEntry = StaticEntityNames; ThisEntry->Name != NULL; ++ThisEntry) {
+        names.insert(EntityNamePair(std::string(ThisEntry->Name), ThisEntry->Value));
+    }
+    return names;
+}
+
+static const EntityNameMap EntityNames = LoadEntityNames();
 
 //////////////////////////////
 //
@@ -6834,16 +6847,6 @@ void HumdrumInput::UnquoteHTML(std::istream &In, std::ostream &Out)
                     ProcessedChar = true;
                 }
                 else if (ThisCh == ';') {
-                    if (EntityNames.empty()) {
-                        /* first use, load EntityNames from StaticEntityNames */
-                        const EntityNameEntry *ThisEntry;
-                        ThisEntry = StaticEntityNames;
-                        for (;;) {
-                            if (ThisEntry->Name == NULL) break;
-                            EntityNames.insert(EntityNamePair(std::string(ThisEntry->Name), ThisEntry->Value));
-                            ++ThisEntry;
-                        }
-                    }
                     const EntityNameMap::const_iterator NameEntry = EntityNames.find(MatchingName);
                     if (NameEntry != EntityNames.end()) {
                         CharCode = NameEntry->second;
@@ -11,6 +11,7 @@
 
 #include <assert.h>
 #include <iostream>
+#include <string.h>
 
 //----------------------------------------------------------------------------
 
@@ -1573,6 +1574,264 @@ std::string MeiOutput::DocTypeToStr(DocType type)
     return value;
 }
 
+//----------------------------------------------------------------------------
+// MeiMdivIndex
+//----------------------------------------------------------------------------
+
+MeiMdivIndex::MeiMdivIndex()
+{
+    Reset();
+}
+
+MeiMdivIndex::~MeiMdivIndex()
+{
+}
+
+void MeiMdivIndex::Reset()
+{
+    m_mdivs.clear();
+    m_bodyContentBegin = std::string::npos;
+    m_bodyEnd = std::string::npos;
+}
+
+bool MeiMdivIndex::Scan(const std::string &mei)
+{
+    Reset();
+
+    // The <mdiv> not closed yet
+    std::vector<int> openMdivs;
+    size_t pos = 0;
+    while ((pos = mei.find('<', pos)) != std::string::npos) {
+        // Comments, CDATA sections, processing instructions and declarations are skipped
+        if (mei.compare(pos, 4, "<!--") == 0) {
+            pos = mei.find("-->", pos + 4);
+            if (pos == std::string::npos) break;
+            pos += 3;
+            continue;
+        }
+        if (mei.compare(pos, 9, "<![CDATA[") == 0) {
+            pos = mei.find("]]>", pos + 9);
+            if (pos == std::string::npos) break;
+            pos += 3;
+            continue;
+        }
+        if ((mei.compare(pos, 2, "<?") == 0) || (mei.compare(pos, 2, "<!") == 0)) {
+            pos = mei.find('>', pos + 2);
+            if (pos == std::string::npos) break;
+            pos += 1;
+            continue;
+        }
+
+        bool isEndTag = (mei.compare(pos, 2, "</") == 0);
+        size_t nameBegin = isEndTag ? pos + 2 : pos + 1;
+        size_t nameEnd = mei.find_first_of(" \t\r\n/>", nameBegin);
+        if (nameEnd == std::string::npos) break;
+
+        // Look for the end of the tag, skipping the '>' in the attribute values
+        size_t tagEnd = nameEnd;
+        char quote = 0;
+        for (; tagEnd < mei.size(); tagEnd++) {
+            char c = mei[tagEnd];
+            if (quote) {
+                if (c == quote) quote = 0;
+            }
+            else if ((c == '"') || (c == '\'')) {
+                quote = c;
+            }
+            else if (c == '>') {
+                break;
+            }
+        }
+        if (tagEnd == mei.size()) break;
+
+        bool isBody = (mei.compare(nameBegin, nameEnd - nameBegin, "body") == 0);
+        bool isMdiv = (mei.compare(nameBegin, nameEnd - nameBegin, "mdiv") == 0);
+        bool inBody = (m_bodyContentBegin != std::string::npos);
+        if (isEndTag) {
+            if (isBody && inBody) {
+                m_bodyEnd = pos;
+                break;
+            }
+            if (isMdiv && inBody) {
+                if (openMdivs.empty()) break;
+                m_mdivs.at(openMdivs.back()).m_end = tagEnd + 1;
+                openMdivs.pop_back();
+            }
+        }
+        else {
+            bool isEmpty = (mei[tagEnd - 1] == '/');
+            if (isBody && !inBody && !isEmpty) {
+                m_bodyContentBegin = tagEnd + 1;
+            }
+            else if (isMdiv && inBody) {
+                MdivEntry mdiv;
+                mdiv.m_level = (int)openMdivs.size();
+                mdiv.m_parent = openMdivs.empty() ? -1 : openMdivs.back();
+                mdiv.m_begin = pos;
+                mdiv.m_contentBegin = tagEnd + 1;
+                mdiv.m_end = tagEnd + 1;
+                m_mdivs.push_back(mdiv);
+                ReadAttributes(mei, nameEnd, tagEnd, (int)m_mdivs.size() - 1);
+                if (!isEmpty) openMdivs.push_back((int)m_mdivs.size() - 1);
+            }
+        }
+        pos = tagEnd + 1;
+    }
+
+    if ((m_bodyEnd == std::string::npos) || !openMdivs.empty()) {
+        LogError("The <mdiv> could not be indexed because the data is not well-formed");
+        Reset();
+        return false;
+    }
+
+    return true;
+}
+
+void MeiMdivIndex::ReadAttributes(const std::string &mei, size_t begin, size_t end, int idx)
+{
+    MdivEntry &mdiv = m_mdivs.at(idx);
+    size_t pos = begin;
+    while (pos < end) {
+        size_t nameBegin = mei.find_first_not_of(" \t\r\n/", pos);
+        if ((nameBegin == std::string::npos) || (nameBegin >= end)) break;
+        size_t equal = mei.find('=', nameBegin);
+        if ((equal == std::string::npos) || (equal >= end)) break;
+        size_t nameEnd = mei.find_last_not_of(" \t\r\n", equal - 1) + 1;
+        size_t valueBegin = mei.find_first_of("\"'", equal);
+        if ((valueBegin == std::string::npos) || (valueBegin >= end)) break;
+        size_t valueEnd = mei.find(mei[valueBegin], valueBegin + 1);
+        if ((valueEnd == std::string::npos) || (valueEnd >= end)) break;
+
+        std::string name = mei.substr(nameBegin, nameEnd - nameBegin);
+        std::string value = mei.substr(valueBegin + 1, valueEnd - valueBegin - 1);
+        // Only the predefined entities are expected in the values we need
+        size_t amp = 0;
+        while ((amp = value.find('&', amp)) != std::string::npos) {
+            if (value.compare(amp, 5, "&amp;") == 0) value.replace(amp, 5, "&");
+            else if (value.compare(amp, 4, "&lt;") == 0) value.replace(amp, 4, "<");
+            else if (value.compare(amp, 4, "&gt;") == 0) value.replace(amp, 4, ">");
+            else if (value.compare(amp, 6, "&quot;") == 0) value.replace(amp, 6, "\"");
+            else if (value.compare(amp, 6, "&apos;") == 0) value.replace(amp, 6, "'");
+            amp++;
+        }
+
+        if (name == "xml:id") {
+            mdiv.m_id = value;
+        }
+        else if (name == "n") {
+            mdiv.m_n = value;
+        }
+        else if (name == "label") {
+            mdiv.m_label = value;
+        }
+        pos = valueEnd + 1;
+    }
+}
+
+std::string MeiMdivIndex::Extract(const std::string &mei, int idx) const
+{
+    const MdivEntry &mdiv = m_mdivs.at(idx);
+
+    // The <mdiv> containing it, from the outermost one
+    std::vector<int> parents;
+    int parent;
+    for (parent = mdiv.m_parent; parent != -1; parent = m_mdivs.at(parent).m_parent) {
+        parents.insert(parents.begin(), parent);
+    }
+
+    std::string data;
+    data.reserve(m_bodyContentBegin + (mdiv.m_end - mdiv.m_begin) + (mei.size() - m_bodyEnd));
+    data.append(mei, 0, m_bodyContentBegin);
+    std::vector<int>::iterator iter;
+    for (iter = parents.begin(); iter != parents.end(); ++iter) {
+        data.append(mei, m_mdivs.at(*iter).m_begin, m_mdivs.at(*iter).m_contentBegin - m_mdivs.at(*iter).m_begin);
+    }
+    data.append(mei, mdiv.m_begin, mdiv.m_end - mdiv.m_begin);
+    for (iter = parents.begin(); iter != parents.end(); ++iter) {
+        data.append("</mdiv>");
+    }
+    data.append(mei, m_bodyEnd, std::string::npos);
+
+    return data;
+}
+
+//----------------------------------------------------------------------------
+// MeiSelectionQuery
+//----------------------------------------------------------------------------
+
+MeiSelectionQuery::MeiSelectionQuery(const std::string &query)
+{
+    m_xpathQuery = NULL;
+    m_hasSource = false;
+    m_isSimple = ParseSimpleQuery(query);
+    if (m_isSimple) return;
+
+    try {
+        m_xpathQuery = new pugi::xpath_query(query.c_str());
+    }
+    catch (pugi::xpath_exception &e) {
+        LogError("The xpath query '%s' is not valid: %s", query.c_str(), e.what());
+        m_xpathQuery = NULL;
+    }
+}
+
+MeiSelectionQuery::~MeiSelectionQuery()
+{
+    if (m_xpathQuery) delete m_xpathQuery;
+}
+
+bool MeiSelectionQuery::ParseSimpleQuery(const std::string &query)
+{
+    size_t pos = 0;
+    // Skip the whitespaces and look for the token at the current position
+    auto expect = [&query, &pos](const char *token) {
+        while ((pos < query.size()) && isspace(query.at(pos))) pos++;
+        size_t length = strlen(token);
+        if (query.compare(pos, length, token) != 0) return false;
+        pos += length;
+        return true;
+    };
+
+    if (!expect("./")) return false;
+    size_t start = pos;
+    while ((pos < query.size()) && (isalnum(query.at(pos)) || (query.at(pos) == '_') || (query.at(pos) == '-'))) {
+        pos++;
+    }
+    if (pos == start) return false;
+    m_name = query.substr(start, pos - start);
+
+    while ((pos < query.size()) && isspace(query.at(pos))) pos++;
+    if (pos == query.size()) return true;
+
+    if (!expect("[") || !expect("contains") || !expect("(") || !expect("@source") || !expect(",")) return false;
+    while ((pos < query.size()) && isspace(query.at(pos))) pos++;
+    if ((pos == query.size()) || ((query.at(pos) != '\'') && (query.at(pos) != '"'))) return false;
+    size_t end = query.find(query.at(pos), pos + 1);
+    if (end == std::string::npos) return false;
+    m_source = query.substr(pos + 1, end - pos - 1);
+    m_hasSource = true;
+    pos = end + 1;
+
+    if (!expect(")") || !expect("]")) return false;
+    while ((pos < query.size()) && isspace(query.at(pos))) pos++;
+    return (pos == query.size());
+}
+
+bool MeiSelectionQuery::MatchesChild(pugi::xml_node child) const
+{
+    if ((child.type() != pugi::node_element) || (m_name != child.name())) return false;
+    if (!m_hasSource) return true;
+
+    return (strstr(child.attribute("source").value(), m_source.c_str()) != NULL);
+}
+
+pugi::xml_node MeiSelectionQuery::Evaluate(pugi::xml_node parentNode) const
+{
+    if (!m_xpathQuery) return pugi::xml_node();
+
+    return m_xpathQuery->evaluate_node(parentNode).node();
+}
+
 //----------------------------------------------------------------------------
 // MeiInput
 //----------------------------------------------------------------------------
@@ -1588,6 +1847,19 @@ MeiInput::MeiInput(Doc *doc, std::string filename) : FileInputStream(doc)
 
 MeiInput::~MeiInput()
 {
+    std::vector<std::string> noQueries;
+    SetSelectionQueries(m_appXPathQueries, noQueries);
+    SetSelectionQueries(m_choiceXPathQueries, noQueries);
+}
+
+void MeiInput::SetAppXPathQueries(std::vector<std::string> &xPathQueries)
+{
+    SetSelectionQueries(m_appXPathQueries, xPathQueries);
+}
+
+void MeiInput::SetChoiceXPathQueries(std::vector<std::string> &xPathQueries)
+{
+    SetSelectionQueries(m_choiceXPathQueries, xPathQueries);
 }
 
 bool MeiInput::ImportFile()
@@ -2065,7 +2337,7 @@ bool MeiInput::ReadMeiPage(pugi::xml_node page)
 
     if (success && (m_doc->GetType() == Transcription) && (vrvPage->GetPPUFactor() != 1.0)) {
         ApplyPPUFactorParams applyPPUFactorParams;
-        Functor applyPPUFactor(&Object::ApplyPPUFactor);
+        Functor applyPPUFactor(&Object::ApplyPPUFactor, "ApplyPPUFactor");
         vrvPage->Process(&applyPPUFactor, &applyPPUFactorParams);
     }
 
@@ -3537,12 +3809,7 @@ bool MeiInput::ReadMeiAppChildren(Object *parent, pugi::xml_node parentNode, Edi
     assert(dynamic_cast<App *>(parent));
 
     // Check if one child node matches the m_appXPathQuery
-    pugi::xml_node selectedLemOrRdg;
-    if (m_appXPathQueries.size() > 0) {
-        auto i = std::find_if(m_appXPathQueries.begin(), m_appXPathQueries.end(),
-            [parentNode](std::string &query) { return (parentNode.select_single_node(query.c_str())); });
-        if (i != m_appXPathQueries.end()) selectedLemOrRdg = parentNode.select_single_node(i->c_str()).node();
-    }
+    pugi::xml_node selectedLemOrRdg = SelectChild(m_appXPathQueries, parentNode);
 
     bool success = true;
     bool hasXPathSelected = false;
@@ -3601,12 +3868,7 @@ bool MeiInput::ReadMeiChoiceChildren(Object *parent, pugi::xml_node parentNode,
     assert(dynamic_cast<Choice *>(parent));
 
     // Check if one child node matches a value in m_choiceXPathQueries
-    pugi::xml_node selectedChild;
-    if (m_choiceXPathQueries.size() > 0) {
-        auto i = std::find_if(m_choiceXPathQueries.begin(), m_choiceXPathQueries.end(),
-            [parentNode](std::string &query) { return (parentNode.select_single_node(query.c_str())); });
-        if (i != m_choiceXPathQueries.end()) selectedChild = parentNode.select_single_node(i->c_str()).node();
-    }
+    pugi::xml_node selectedChild = SelectChild(m_choiceXPathQueries, parentNode);
 
     bool success = true;
     bool hasXPathSelected = false;
@@ -4010,4 +4272,54 @@ bool MeiInput::IsEditorialElementName(std::string elementName)
     return false;
 }
 
+pugi::xml_node MeiInput::SelectChild(const std::vector<MeiSelectionQuery *> &queries, pugi::xml_node parentNode)
+{
+    if (queries.empty()) return pugi::xml_node();
+
+    int i;
+    // The first child matching a simple query, and the index of that query
+    pugi::xml_node selected;
+    int selectedIdx = (int)queries.size();
+    pugi::xml_node child;
+    for (child = parentNode.first_child(); child && (selectedIdx > 0); child = child.next_sibling()) {
+        for (i = 0; i < selectedIdx; i++) {
+            if (queries.at(i)->IsSimple() && queries.at(i)->MatchesChild(child)) {
+                selected = child;
+                selectedIdx = i;
+                break;
+            }
+        }
+    }
+
+    // The other queries coming before it are evaluated in their order
+    for (i = 0; i < selectedIdx; i++) {
+        if (queries.at(i)->IsSimple()) continue;
+        pugi::xml_node node = queries.at(i)->Evaluate(parentNode);
+        if (node) return node;
+    }
+
+    return selected;
+}
+
+void MeiInput::SetSelectionQueries(
+    std::vector<MeiSelectionQuery *> &queries, const std::vector<std::string> &xPathQueries)
+{
+    std::vector<MeiSelectionQuery *>::iterator iter;
+    for (iter = queries.begin(); iter != queries.end(); ++iter) {
+        delete (*iter);
+    }
+    queries.clear();
+
+    std::vector<std::string>::const_iterator queryIter;
+    for (queryIter = xPathQueries.begin(); queryIter != xPathQueries.end(); ++queryIter) {
+        MeiSelectionQuery *query = new MeiSelectionQuery(*queryIter);
+        if (query->IsValid()) {
+            queries.push_back(query);
+        }
+        else {
+            delete query;
+        }
+    }
+}
+
 } // namespace vrv
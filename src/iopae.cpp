@@ -56,11 +56,7 @@ char hum2abc[1024] = { 0 }; // used with -a option
 int quietQ = 0; // used with -q option
 int quiet2Q = 0; // used with -Q option
 
-// Global variables:
-char data_line[10001] = { 0 };
 #define MAX_DATA_LEN 1024 // One line of the pae file would not be that long!
-char data_key[MAX_DATA_LEN];
-char data_value[MAX_DATA_LEN]; // ditto as above
 
 //----------------------------------------------------------------------------
 // PaeInput
@@ -126,6 +122,10 @@ void PaeInput::parsePlainAndEasy(std::istream &infile)
     char c_timesig[1024] = { 0 };
     char c_alttimesig[1024] = { 0 };
     char incipit[10001] = { 0 };
+    // line buffers - not global so that several documents can be parsed concurrently
+    char data_line[10001] = { 0 };
+    char data_key[MAX_DATA_LEN] = { 0 };
+    char data_value[MAX_DATA_LEN] = { 0 }; // ditto as above
     int in_beam = 0;
 
     std::string s_key;
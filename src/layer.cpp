@@ -295,6 +295,21 @@ int Layer::UnsetCurrentScoreDef(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 };
 
+int Layer::ResetHorizontalAlignment(FunctorParams *functorParams)
+{
+    // The scoreDef objects are not children of the layer and they can be copied from an element already aligned
+    if (m_staffDefClef) m_staffDefClef->ResetHorizontalAlignment(functorParams);
+    if (m_staffDefKeySig) m_staffDefKeySig->ResetHorizontalAlignment(functorParams);
+    if (m_staffDefMensur) m_staffDefMensur->ResetHorizontalAlignment(functorParams);
+    if (m_staffDefMeterSig) m_staffDefMeterSig->ResetHorizontalAlignment(functorParams);
+    if (m_cautionStaffDefClef) m_cautionStaffDefClef->ResetHorizontalAlignment(functorParams);
+    if (m_cautionStaffDefKeySig) m_cautionStaffDefKeySig->ResetHorizontalAlignment(functorParams);
+    if (m_cautionStaffDefMensur) m_cautionStaffDefMensur->ResetHorizontalAlignment(functorParams);
+    if (m_cautionStaffDefMeterSig) m_cautionStaffDefMeterSig->ResetHorizontalAlignment(functorParams);
+
+    return FUNCTOR_CONTINUE;
+}
+
 int Layer::AlignHorizontally(FunctorParams *functorParams)
 {
     AlignHorizontallyParams *params = dynamic_cast<AlignHorizontallyParams *>(functorParams);
@@ -436,4 +451,34 @@ int Layer::CalcMaxMeasureDuration(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 }
 
+int Layer::GenerateMIDI(FunctorParams *functorParams)
+{
+    GenerateMIDIParams *params = dynamic_cast<GenerateMIDIParams *>(functorParams);
+    assert(params);
+
+    Staff *staff = dynamic_cast<Staff *>(this->GetFirstParent(STAFF));
+    assert(staff);
+
+    // Continue from the time reached by the previous layer with the same staff/layer @n in the measure (if any)
+    params->m_currentLayerN = std::make_pair(staff->GetN(), this->GetN());
+    params->m_currentMeasureTime = params->m_layerMeasureTimes[params->m_currentLayerN];
+    params->m_currentLayerNotes = &params->m_layerNotes[params->m_currentLayerN];
+    // The layer is also cached without notes so that the track of its staff is still created from the cache
+    assert(params->m_currentMeasureNotes);
+    (*params->m_currentMeasureNotes)[params->m_currentLayerN];
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Layer::GenerateMIDIEnd(FunctorParams *functorParams)
+{
+    GenerateMIDIParams *params = dynamic_cast<GenerateMIDIParams *>(functorParams);
+    assert(params);
+
+    params->m_layerMeasureTimes[params->m_currentLayerN] = params->m_currentMeasureTime;
+    params->m_currentLayerNotes = NULL;
+
+    return FUNCTOR_CONTINUE;
+}
+
 } // namespace vrv
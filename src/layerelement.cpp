@@ -1251,22 +1251,20 @@ int LayerElement::GenerateMIDI(FunctorParams *functorParams)
             }
         }
 
-        // Adjustment for transposition intruments
-        midiBase += params->m_transSemi;
+        // The adjustment for transposition intruments is applied when the notes are written to the track
 
         int oct = note->GetOct();
         if (note->HasOctGes()) oct = note->GetOctGes();
 
         int pitch = midiBase + (oct + 1) * 12;
-        int channel = 0;
-        int velocity = 64;
-        params->m_midiFile->addNoteOn(
-            params->m_midiTrack, params->m_totalTime + params->m_currentMeasureTime, channel, pitch, velocity);
-        params->m_midiFile->addNoteOff(
-            params->m_midiTrack, params->m_totalTime + params->m_currentMeasureTime + dur, channel, pitch);
-
-        note->m_playingOnset = params->m_totalTime + params->m_currentMeasureTime;
-        note->m_playingOffset = params->m_totalTime + params->m_currentMeasureTime + dur;
+        assert(params->m_currentLayerNotes);
+        params->m_currentLayerNotes->push_back(std::make_tuple(
+            params->m_measureIdx, params->m_currentMeasureTime, params->m_currentMeasureTime + dur, pitch, note));
+        // The notes are also cached by measure for the next export
+        assert(params->m_currentMeasureNotes);
+        (*params->m_currentMeasureNotes)[params->m_currentLayerN].push_back(params->m_currentLayerNotes->back());
+
+        // The playing onset and offset of the note are set when the notes are written to the track
 
         // increase the currentTime accordingly, but only if not in a chord - checkit with note->IsChordTone()
         if (!(note->IsChordTone())) {
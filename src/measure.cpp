@@ -27,6 +27,7 @@
 #include "syl.h"
 #include "system.h"
 #include "timeinterface.h"
+#include "timemap.h"
 #include "timestamp.h"
 #include "vrv.h"
 
@@ -99,6 +100,10 @@ void Measure::Reset()
 
     m_drawingEnding = NULL;
     m_hasAlignmentRefWithMultipleLayers = false;
+
+    m_midiCacheValid = false;
+    m_midiCachedDuration = 0.0;
+    m_midiCachedTempos.clear();
 }
 
 void Measure::AddChild(Object *child)
@@ -377,7 +382,7 @@ int Measure::ResetHorizontalAlignment(FunctorParams *functorParams)
         m_measureAligner.GetRightAlignment()->SetXRel(0);
     }
 
-    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment);
+    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment, "ResetHorizontalAlignment");
     m_timestampAligner.Process(&resetHorizontalAlignment, NULL);
 
     m_hasAlignmentRefWithMultipleLayers = false;
@@ -625,6 +630,7 @@ int Measure::CastOffSystems(FunctorParams *functorParams)
                > params->m_systemWidth)) {
         params->m_currentSystem = new System();
         params->m_page->AddChild(params->m_currentSystem);
+        params->m_currentSystem->m_castOffScoreDefWidth = params->m_currentScoreDefWidth;
         params->m_shift = this->m_drawingXRel;
     }
 
@@ -833,8 +839,31 @@ int Measure::GenerateMIDI(FunctorParams *functorParams)
     GenerateMIDIParams *params = dynamic_cast<GenerateMIDIParams *>(functorParams);
     assert(params);
 
-    // Here we need to reset the currentMeasureTime because we are starting a new measure
+    // The notes cached by the previous export are used as they are - only their measure index might have changed
+    if (m_midiCacheValid) {
+        assert(params->m_cachedNotes);
+        MapOfMeasureMIDINoteTuples::const_iterator cached = params->m_cachedNotes->find(this);
+        if (cached != params->m_cachedNotes->end()) {
+            params->m_measureNotes[this] = cached->second;
+            MapOfMIDINoteTuples::const_iterator layers;
+            ArrayOfMIDINoteTuples::const_iterator notes;
+            for (layers = cached->second.begin(); layers != cached->second.end(); ++layers) {
+                ArrayOfMIDINoteTuples &layerNotes = params->m_layerNotes[layers->first];
+                for (notes = layers->second.begin(); notes != layers->second.end(); ++notes) {
+                    layerNotes.push_back(*notes);
+                    std::get<0>(layerNotes.back()) = params->m_measureIdx;
+                }
+            }
+        }
+        // GenerateMIDIEnd is not called since we skip the content
+        params->m_measureIdx++;
+        return FUNCTOR_SIBLINGS;
+    }
+
+    // Here we need to reset the currentMeasureTime of each layer because we are starting a new measure
     params->m_currentMeasureTime = 0;
+    params->m_layerMeasureTimes.clear();
+    params->m_currentMeasureNotes = &params->m_measureNotes[this];
 
     return FUNCTOR_CONTINUE;
 }
@@ -844,12 +873,10 @@ int Measure::GenerateMIDIEnd(FunctorParams *functorParams)
     GenerateMIDIParams *params = dynamic_cast<GenerateMIDIParams *>(functorParams);
     assert(params);
 
-    // We a to the total time the maximum duration of the measure so if there is no layer, if the layer is not full
-    // or
-    // if there is an encoding error in the measure, the next one will be properly aligned
-    assert(!params->m_maxValues.empty());
-    params->m_totalTime += params->m_maxValues.front();
-    params->m_maxValues.erase(params->m_maxValues.begin());
+    // The next measure starts after the maximum duration of this one so if there is no layer, if the layer is not
+    // full or if there is an encoding error in the measure, it will be properly aligned
+    params->m_measureIdx++;
+    params->m_currentMeasureNotes = NULL;
 
     return FUNCTOR_CONTINUE;
 }
@@ -858,9 +885,48 @@ int Measure::CalcMaxMeasureDuration(FunctorParams *functorParams)
 {
     CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
     assert(params);
+    assert(params->m_timemap);
+
+    // Any change in the content of the measure since the previous export invalidates its cached MIDI data
+    if (this->IsModified()) m_midiCacheValid = false;
+    this->Modify(false);
+
+    params->m_timemap->AddMeasure(this->GetUuid());
+
+    // The content does not need to be processed when the duration and the tempo changes are cached
+    if (m_midiCacheValid) {
+        params->m_maxValues.push_back(m_midiCachedDuration);
+        std::vector<std::pair<double, double> >::iterator iter;
+        for (iter = m_midiCachedTempos.begin(); iter != m_midiCachedTempos.end(); ++iter) {
+            params->m_timemap->AddTempo((int)params->m_maxValues.size() - 1, iter->first, iter->second);
+        }
+        return FUNCTOR_SIBLINGS;
+    }
 
     // We just need to add a value to the stack
     params->m_maxValues.push_back(0.0);
+    params->m_measureTempos.clear();
+
+    return FUNCTOR_CONTINUE;
+}
+
+int Measure::CalcMaxMeasureDurationEnd(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    // Cache the duration and the tempo changes for the next export
+    m_midiCachedDuration = params->m_maxValues.back();
+    m_midiCachedTempos = params->m_measureTempos;
+    std::vector<std::pair<double, double> >::iterator iter;
+    for (iter = m_midiCachedTempos.begin(); iter != m_midiCachedTempos.end(); ++iter) {
+        params->m_timemap->AddTempo((int)params->m_maxValues.size() - 1, iter->first, iter->second);
+    }
+    params->m_measureTempos.clear();
+
+    // The MIDI data of the measure will be generated again
+    params->m_modifiedMeasures.push_back(this);
 
     return FUNCTOR_CONTINUE;
 }
@@ -263,7 +263,7 @@ Point Note::GetStemUpSE(Doc *doc, int staffSize, bool graceSize)
         return p;
     }
 
-    Glyph *glyph = Resources::GetGlyph(code);
+    Glyph *glyph = doc->GetMusicFont()->GetGlyph(code);
     assert(glyph);
 
     if (glyph->HasAnchor(SMUFL_stemUpSE)) {
@@ -302,7 +302,7 @@ Point Note::GetStemDownNW(Doc *doc, int staffSize, bool graceSize)
         return p;
     }
 
-    Glyph *glyph = Resources::GetGlyph(code);
+    Glyph *glyph = doc->GetMusicFont()->GetGlyph(code);
     assert(glyph);
 
     if (glyph->HasAnchor(SMUFL_stemDownNW)) {
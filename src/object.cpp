@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <iostream>
 #include <math.h>
+#include <mutex>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -41,11 +42,119 @@
 
 namespace vrv {
 
+/**
+ * The sizes of the objects are rounded up to the granularity and only the ones up to the maximum size are kept.
+ * No more than the maximum free bytes are kept for all the threads together.
+ */
+#define OBJECT_ALLOC_GRANULARITY 16
+#define OBJECT_ALLOC_MAX_SIZE 4096
+#define OBJECT_ALLOC_MAX_FREE_BYTES (64 * 1024 * 1024)
+
+//----------------------------------------------------------------------------
+// ObjectPool
+//----------------------------------------------------------------------------
+
+/**
+ * This class holds the memory of the objects deleted, as one linked list per rounded size, shared by all the threads.
+ * It has no constructor so that it is zero-initialized before any object is created, and it is released when the
+ * program ends.
+ */
+class ObjectPool {
+public:
+    ~ObjectPool()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int i;
+        for (i = 0; i < OBJECT_ALLOC_MAX_SIZE / OBJECT_ALLOC_GRANULARITY; i++) {
+            while (m_lists[i]) {
+                void *ptr = m_lists[i];
+                m_lists[i] = *(void **)ptr;
+                ::operator delete(ptr);
+            }
+        }
+        m_freeBytes = 0;
+        // The objects deleted afterwards are released directly
+        m_released = true;
+    }
+
+    std::mutex m_mutex;
+    void *m_lists[OBJECT_ALLOC_MAX_SIZE / OBJECT_ALLOC_GRANULARITY];
+    size_t m_freeBytes;
+#ifdef USE_ALLOCATION_COUNTING
+    unsigned long long m_reusedAllocations;
+    unsigned long long m_reusedBytes;
+#endif
+    bool m_released;
+};
+
+static ObjectPool s_objectPool;
+
 //----------------------------------------------------------------------------
 // Object
 //----------------------------------------------------------------------------
 
-unsigned long Object::s_objectCounter = 0;
+std::atomic<unsigned long> Object::s_objectCounter(0);
+
+void *Object::operator new(size_t size)
+{
+    if (size > OBJECT_ALLOC_MAX_SIZE) return ::operator new(size);
+
+    int idx = (int)((size + OBJECT_ALLOC_GRANULARITY - 1) / OBJECT_ALLOC_GRANULARITY) - 1;
+    size_t allocSize = (idx + 1) * OBJECT_ALLOC_GRANULARITY;
+    {
+        std::lock_guard<std::mutex> lock(s_objectPool.m_mutex);
+        void *ptr = s_objectPool.m_lists[idx];
+        if (ptr) {
+            s_objectPool.m_lists[idx] = *(void **)ptr;
+            s_objectPool.m_freeBytes -= allocSize;
+#ifdef USE_ALLOCATION_COUNTING
+            s_objectPool.m_reusedAllocations++;
+            s_objectPool.m_reusedBytes += allocSize;
+#endif
+            return ptr;
+        }
+    }
+    // Allocate the rounded size so that the memory can be used again for any object of that size
+    return ::operator new(allocSize);
+}
+
+void Object::operator delete(void *ptr, size_t size)
+{
+    if (!ptr) return;
+
+    if (size <= OBJECT_ALLOC_MAX_SIZE) {
+        int idx = (int)((size + OBJECT_ALLOC_GRANULARITY - 1) / OBJECT_ALLOC_GRANULARITY) - 1;
+        size_t allocSize = (idx + 1) * OBJECT_ALLOC_GRANULARITY;
+        std::lock_guard<std::mutex> lock(s_objectPool.m_mutex);
+        if (!s_objectPool.m_released && (s_objectPool.m_freeBytes + allocSize <= OBJECT_ALLOC_MAX_FREE_BYTES)) {
+            *(void **)ptr = s_objectPool.m_lists[idx];
+            s_objectPool.m_lists[idx] = ptr;
+            s_objectPool.m_freeBytes += allocSize;
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+unsigned long long Object::GetReusedAllocations()
+{
+#ifdef USE_ALLOCATION_COUNTING
+    std::lock_guard<std::mutex> lock(s_objectPool.m_mutex);
+    return s_objectPool.m_reusedAllocations;
+#else
+    return 0;
+#endif
+}
+
+unsigned long long Object::GetReusedBytes()
+{
+#ifdef USE_ALLOCATION_COUNTING
+    std::lock_guard<std::mutex> lock(s_objectPool.m_mutex);
+    return s_objectPool.m_reusedBytes;
+#else
+    return 0;
+#endif
+}
 
 Object::Object() : BoundingBox()
 {
@@ -350,7 +459,7 @@ void Object::ClearRelinquishedChildren()
 
 Object *Object::FindChildByUuid(std::string uuid, int deepness, bool direction)
 {
-    Functor findByUuid(&Object::FindByUuid);
+    Functor findByUuid(&Object::FindByUuid, "FindByUuid");
     FindByUuidParams findbyUuidParams;
     findbyUuidParams.m_uuid = uuid;
     this->Process(&findByUuid, &findbyUuidParams, NULL, NULL, deepness, direction);
@@ -365,7 +474,7 @@ Object *Object::FindChildByType(ClassId classId, int deepness, bool direction)
 
 Object *Object::FindChildByAttComparison(AttComparison *attComparison, int deepness, bool direction)
 {
-    Functor findByAttComparison(&Object::FindByAttComparison);
+    Functor findByAttComparison(&Object::FindByAttComparison, "FindByAttComparison");
     FindByAttComparisonParams findByAttComparisonParams(attComparison);
     this->Process(&findByAttComparison, &findByAttComparisonParams, NULL, NULL, deepness, direction);
     return findByAttComparisonParams.m_element;
@@ -373,7 +482,7 @@ Object *Object::FindChildByAttComparison(AttComparison *attComparison, int deepn
 
 Object *Object::FindChildExtremeByAttComparison(AttComparison *attComparison, int deepness, bool direction)
 {
-    Functor findExtremeByAttComparison(&Object::FindExtremeByAttComparison);
+    Functor findExtremeByAttComparison(&Object::FindExtremeByAttComparison, "FindExtremeByAttComparison");
     FindExtremeByAttComparisonParams findExtremeByAttComparisonParams(attComparison);
     this->Process(&findExtremeByAttComparison, &findExtremeByAttComparisonParams, NULL, NULL, deepness, direction);
     return findExtremeByAttComparisonParams.m_element;
@@ -385,7 +494,7 @@ void Object::FindAllChildByAttComparison(
     assert(objects);
     if (clear) objects->clear();
 
-    Functor findAllByAttComparison(&Object::FindAllByAttComparison);
+    Functor findAllByAttComparison(&Object::FindAllByAttComparison, "FindAllByAttComparison");
     FindAllByAttComparisonParams findAllByAttComparisonParams(attComparison, objects);
     this->Process(&findAllByAttComparison, &findAllByAttComparisonParams, NULL, NULL, deepness, direction);
 }
@@ -507,7 +616,7 @@ void Object::Modify(bool modified)
 
 void Object::FillFlatList(ListOfObjects *flatList)
 {
-    Functor addToFlatList(&Object::AddLayerElementToFlatList);
+    Functor addToFlatList(&Object::AddLayerElementToFlatList, "AddLayerElementToFlatList");
     AddLayerElementToFlatListParams addLayerElementToFlatListParams(flatList);
     this->Process(&addToFlatList, &addLayerElementToFlatListParams);
 }
@@ -554,9 +663,50 @@ Object *Object::GetLastParentNot(const ClassId classId, int maxDepth)
     }
 }
 
+#ifdef USE_PROFILING
+/**
+ * This class counts the objects a functor reaches and adds its pass (and the one of the end functor) to the
+ * profile when the outermost Object::Process call with it returns.
+ */
+class ObjectProcessProfile {
+public:
+    ObjectProcessProfile(Functor *functor, Functor *endFunctor)
+    {
+        m_functor = functor;
+        m_endFunctor = endFunctor;
+        if (m_functor->m_profile.m_processDepth++ == 0) {
+            m_functor->m_profile.m_passStart = std::chrono::steady_clock::now();
+        }
+        m_functor->m_profile.m_visited++;
+    }
+
+    ~ObjectProcessProfile()
+    {
+        if (--m_functor->m_profile.m_processDepth > 0) return;
+
+        ProfileTime end = std::chrono::steady_clock::now();
+        Profiler::AddFunctorPass(m_functor->GetName(), m_functor->m_profile, m_functor->m_profile.m_passStart, end);
+        m_functor->m_profile.Reset();
+        if (m_endFunctor) {
+            Profiler::AddFunctorPass(m_endFunctor->GetName(), m_endFunctor->m_profile, end, end);
+            m_endFunctor->m_profile.Reset();
+        }
+    }
+
+private:
+    Functor *m_functor;
+    Functor *m_endFunctor;
+};
+#endif
+
 void Object::Process(Functor *functor, FunctorParams *functorParams, Functor *endFunctor,
     ArrayOfAttComparisons *filters, int deepness, bool direction)
 {
+#ifdef USE_PROFILING
+    // The pass is added to the profile when the outermost call returns
+    ObjectProcessProfile processProfile(functor, endFunctor);
+#endif
+
     if (functor->m_returnCode == FUNCTOR_STOP) {
         return;
     }
@@ -638,10 +788,10 @@ int Object::Save(FileOutputStream *output)
 {
     SaveParams saveParams(output);
 
-    Functor save(&Object::Save);
+    Functor save(&Object::Save, "Save");
     // Special case where we want to process all objects
     save.m_visibleOnly = false;
-    Functor saveEnd(&Object::SaveEnd);
+    Functor saveEnd(&Object::SaveEnd, "SaveEnd");
     this->Process(&save, &saveParams, &saveEnd);
 
     return true;
@@ -792,19 +942,36 @@ Functor::Functor()
     m_returnCode = FUNCTOR_CONTINUE;
     m_visibleOnly = true;
     obj_fpt = NULL;
+    m_name = "";
 }
 
-Functor::Functor(int (Object::*_obj_fpt)(FunctorParams *))
+Functor::Functor(int (Object::*_obj_fpt)(FunctorParams *), const char *name)
 {
     m_returnCode = FUNCTOR_CONTINUE;
     m_visibleOnly = true;
     obj_fpt = _obj_fpt;
+    m_name = name;
 }
 
 void Functor::Call(Object *ptr, FunctorParams *functorParams)
 {
+#ifdef USE_PROFILING
+    // Only the outermost call is timed since functors can process the children themselves
+    m_profile.m_actedOn++;
+    if (m_profile.m_callDepth++ == 0) m_profile.m_callStart = std::chrono::steady_clock::now();
+#endif
+
     // we should have return codes (not just bool) for avoiding to go further down the tree in some cases
     m_returnCode = (*ptr.*obj_fpt)(functorParams);
+
+#ifdef USE_PROFILING
+    if (--m_profile.m_callDepth == 0) {
+        ClassId classId = ptr->GetClassId();
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()
+            - m_profile.m_callStart).count();
+        m_profile.AddCall(classId, (m_profile.m_classes.count(classId) == 0) ? ptr->GetClassName() : "", time);
+    }
+#endif
 }
 
 //----------------------------------------------------------------------------
@@ -956,7 +1123,7 @@ int Object::SetCurrentScoreDef(FunctorParams *functorParams)
             if (params->m_upcomingScoreDef->m_setAsDrawing && params->m_previousMeasure) {
                 ScoreDef cautionaryScoreDef = *params->m_upcomingScoreDef;
                 SetCautionaryScoreDefParams setCautionaryScoreDefParams(&cautionaryScoreDef);
-                Functor setCautionaryScoreDef(&Object::SetCautionaryScoreDef);
+                Functor setCautionaryScoreDef(&Object::SetCautionaryScoreDef, "SetCautionaryScoreDef");
                 params->m_previousMeasure->Process(&setCautionaryScoreDef, &setCautionaryScoreDefParams);
             }
             // Set the flags we want to have. This also sets m_setAsDrawing to true so the next measure will keep it
@@ -95,44 +95,44 @@ void Page::LayOutTranscription(bool force)
     assert(this == doc->GetDrawingPage());
 
     // Reset the horizontal alignment
-    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment);
+    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment, "ResetHorizontalAlignment");
     this->Process(&resetHorizontalAlignment, NULL);
 
     // Reset the vertical alignment
-    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment);
+    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment, "ResetVerticalAlignment");
     this->Process(&resetVerticalAlignment, NULL);
 
     // Align the content of the page using measure aligners
     // After this:
     // - each LayerElement object will have its Alignment pointer initialized
-    Functor alignHorizontally(&Object::AlignHorizontally);
-    Functor alignHorizontallyEnd(&Object::AlignHorizontallyEnd);
+    Functor alignHorizontally(&Object::AlignHorizontally, "AlignHorizontally");
+    Functor alignHorizontallyEnd(&Object::AlignHorizontallyEnd, "AlignHorizontallyEnd");
     AlignHorizontallyParams alignHorizontallyParams(&alignHorizontally);
     this->Process(&alignHorizontally, &alignHorizontallyParams, &alignHorizontallyEnd);
 
     // Align the content of the page using system aligners
     // After this:
     // - each Staff object will then have its StaffAlignment pointer initialized
-    Functor alignVertically(&Object::AlignVertically);
-    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd);
+    Functor alignVertically(&Object::AlignVertically, "AlignVertically");
+    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd, "AlignVerticallyEnd");
     AlignVerticallyParams alignVerticallyParams(doc, &alignVerticallyEnd);
     this->Process(&alignVertically, &alignVerticallyParams, &alignVerticallyEnd);
 
     // Set the pitch / pos alignement
     SetAlignmentPitchPosParams setAlignmentPitchPosParams(doc);
-    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos);
+    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos, "SetAlignmentPitchPos");
     this->Process(&setAlignmentPitchPos, &setAlignmentPitchPosParams);
 
     CalcStemParams calcStemParams(doc);
-    Functor calcStem(&Object::CalcStem);
+    Functor calcStem(&Object::CalcStem, "CalcStem");
     this->Process(&calcStem, &calcStemParams);
 
     FunctorDocParams calcChordNoteHeadsParams(doc);
-    Functor calcChordNoteHeads(&Object::CalcChordNoteHeads);
+    Functor calcChordNoteHeads(&Object::CalcChordNoteHeads, "CalcChordNoteHeads");
     this->Process(&calcChordNoteHeads, &calcChordNoteHeadsParams);
 
     CalcDotsParams calcDotsParams(doc);
-    Functor calcDots(&Object::CalcDots);
+    Functor calcDots(&Object::CalcDots, "CalcDots");
     this->Process(&calcDots, &calcDotsParams);
 
     // Render it for filling the bounding box
@@ -143,18 +143,20 @@ void Page::LayOutTranscription(bool force)
     view.SetPage(this->GetIdx(), false);
     view.DrawCurrentPage(&bBoxDC, false);
 
-    Functor adjustXRelForTranscription(&Object::AdjustXRelForTranscription);
+    Functor adjustXRelForTranscription(&Object::AdjustXRelForTranscription, "AdjustXRelForTranscription");
     this->Process(&adjustXRelForTranscription, NULL);
 
     FunctorDocParams calcLegerLinesParams(doc);
-    Functor calcLedgerLines(&Object::CalcLedgerLines);
+    Functor calcLedgerLines(&Object::CalcLedgerLines, "CalcLedgerLines");
     this->Process(&calcLedgerLines, &calcLegerLinesParams);
 
     m_layoutDone = true;
 }
 
-void Page::LayOutHorizontally()
+void Page::LayOutHorizontally(int longestActualDur)
 {
+    PROFILE_STAGE("Page::LayOutHorizontally");
+
     Doc *doc = dynamic_cast<Doc *>(GetParent());
     assert(doc);
 
@@ -163,36 +165,39 @@ void Page::LayOutHorizontally()
     assert(this == doc->GetDrawingPage());
 
     // Reset the horizontal alignment
-    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment);
+    Functor resetHorizontalAlignment(&Object::ResetHorizontalAlignment, "ResetHorizontalAlignment");
     this->Process(&resetHorizontalAlignment, NULL);
 
     // Reset the vertical alignment
-    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment);
+    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment, "ResetVerticalAlignment");
     this->Process(&resetVerticalAlignment, NULL);
 
     // Align the content of the page using measure aligners
     // After this:
     // - each LayerElement object will have its Alignment pointer initialized
-    Functor alignHorizontally(&Object::AlignHorizontally);
-    Functor alignHorizontallyEnd(&Object::AlignHorizontallyEnd);
+    Functor alignHorizontally(&Object::AlignHorizontally, "AlignHorizontally");
+    Functor alignHorizontallyEnd(&Object::AlignHorizontallyEnd, "AlignHorizontallyEnd");
     AlignHorizontallyParams alignHorizontallyParams(&alignHorizontally);
     this->Process(&alignHorizontally, &alignHorizontallyParams, &alignHorizontallyEnd);
 
     // Align the content of the page using system aligners
     // After this:
     // - each Staff object will then have its StaffAlignment pointer initialized
-    Functor alignVertically(&Object::AlignVertically);
-    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd);
+    Functor alignVertically(&Object::AlignVertically, "AlignVertically");
+    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd, "AlignVerticallyEnd");
     AlignVerticallyParams alignVerticallyParams(doc, &alignVerticallyEnd);
     this->Process(&alignVertically, &alignVerticallyParams, &alignVerticallyEnd);
 
     // Unless duration-based spacing is disabled, set the X position of each Alignment.
     // Does non-linear spacing based on the duration space between two Alignment objects.
     if (!doc->GetEvenSpacing()) {
-        int longestActualDur = DUR_4;
         // Get the longest duration in the piece
         AttDurExtreme durExtremeComparison(LONGEST);
-        Object *longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
+        Object *longestDur = NULL;
+        if (longestActualDur == VRV_UNSET) {
+            longestActualDur = DUR_4;
+            longestDur = this->FindChildExtremeByAttComparison(&durExtremeComparison);
+        }
         if (longestDur) {
             DurationInterface *interface = longestDur->GetDurationInterface();
             assert(interface);
@@ -200,7 +205,7 @@ void Page::LayOutHorizontally()
             // LogDebug("Longest duration is DUR_* code %d", longestActualDur);
         }
 
-        Functor setAlignmentX(&Object::SetAlignmentXPos);
+        Functor setAlignmentX(&Object::SetAlignmentXPos, "SetAlignmentXPos");
         SetAlignmentXPosParams setAlignmentXPosParams(doc, &setAlignmentX);
         setAlignmentXPosParams.m_longestActualDur = longestActualDur;
         this->Process(&setAlignmentX, &setAlignmentXPosParams);
@@ -208,19 +213,19 @@ void Page::LayOutHorizontally()
 
     // Set the pitch / pos alignement
     SetAlignmentPitchPosParams setAlignmentPitchPosParams(doc);
-    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos);
+    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos, "SetAlignmentPitchPos");
     this->Process(&setAlignmentPitchPos, &setAlignmentPitchPosParams);
 
     CalcStemParams calcStemParams(doc);
-    Functor calcStem(&Object::CalcStem);
+    Functor calcStem(&Object::CalcStem, "CalcStem");
     this->Process(&calcStem, &calcStemParams);
 
     FunctorDocParams calcChordNoteHeadsParams(doc);
-    Functor calcChordNoteHeads(&Object::CalcChordNoteHeads);
+    Functor calcChordNoteHeads(&Object::CalcChordNoteHeads, "CalcChordNoteHeads");
     this->Process(&calcChordNoteHeads, &calcChordNoteHeadsParams);
 
     CalcDotsParams calcDotsParams(doc);
-    Functor calcDots(&Object::CalcDots);
+    Functor calcDots(&Object::CalcDots, "CalcDots");
     this->Process(&calcDots, &calcDotsParams);
 
     // Render it for filling the bounding box
@@ -233,26 +238,26 @@ void Page::LayOutHorizontally()
 
     // Adjust the x position of the LayerElement where multiple layer collide
     // Look at each LayerElement and change the m_xShift if the bounding box is overlapping
-    Functor adjustLayers(&Object::AdjustLayers);
+    Functor adjustLayers(&Object::AdjustLayers, "AdjustLayers");
     AdjustLayersParams adjustLayersParams(doc, &adjustLayers, doc->m_scoreDef.GetStaffNs());
     this->Process(&adjustLayers, &adjustLayersParams);
 
     // Adjust the X position of the accidentals, including in chords
-    Functor adjustAccidX(&Object::AdjustAccidX);
+    Functor adjustAccidX(&Object::AdjustAccidX, "AdjustAccidX");
     AdjustAccidXParams adjustAccidXParams(doc, &adjustAccidX);
     this->Process(&adjustAccidX, &adjustAccidXParams);
 
     // Adjust the X shift of the Alignment looking at the bounding boxes
     // Look at each LayerElement and change the m_xShift if the bounding box is overlapping
-    Functor adjustXPos(&Object::AdjustXPos);
-    Functor adjustXPosEnd(&Object::AdjustXPosEnd);
+    Functor adjustXPos(&Object::AdjustXPos, "AdjustXPos");
+    Functor adjustXPosEnd(&Object::AdjustXPosEnd, "AdjustXPosEnd");
     AdjustXPosParams adjustXPosParams(doc, &adjustXPos, &adjustXPosEnd, doc->m_scoreDef.GetStaffNs());
     this->Process(&adjustXPos, &adjustXPosParams, &adjustXPosEnd);
 
     // Adjust the X shift of the Alignment looking at the bounding boxes
     // Look at each LayerElement and change the m_xShift if the bounding box is overlapping
-    Functor adjustGraceXPos(&Object::AdjustGraceXPos);
-    Functor adjustGraceXPosEnd(&Object::AdjustGraceXPosEnd);
+    Functor adjustGraceXPos(&Object::AdjustGraceXPos, "AdjustGraceXPos");
+    Functor adjustGraceXPosEnd(&Object::AdjustGraceXPosEnd, "AdjustGraceXPosEnd");
     AdjustGraceXPosParams adjustGraceXPosParams(
         doc, &adjustGraceXPos, &adjustGraceXPosEnd, doc->m_scoreDef.GetStaffNs());
     this->Process(&adjustGraceXPos, &adjustGraceXPosParams, &adjustGraceXPosEnd);
@@ -260,20 +265,22 @@ void Page::LayOutHorizontally()
     // We need to populate processing lists for processing the document by Layer (for matching @tie) and
     // by Verse (for matching syllable connectors)
     PrepareProcessingListsParams prepareProcessingListsParams;
-    Functor prepareProcessingLists(&Object::PrepareProcessingLists);
+    Functor prepareProcessingLists(&Object::PrepareProcessingLists, "PrepareProcessingLists");
     this->Process(&prepareProcessingLists, &prepareProcessingListsParams);
 
     this->AdjustSylSpacingByVerse(prepareProcessingListsParams, doc);
 
     // Adjust measure X position
     AlignMeasuresParams alignMeasuresParams;
-    Functor alignMeasures(&Object::AlignMeasures);
-    Functor alignMeasuresEnd(&Object::AlignMeasuresEnd);
+    Functor alignMeasures(&Object::AlignMeasures, "AlignMeasures");
+    Functor alignMeasuresEnd(&Object::AlignMeasuresEnd, "AlignMeasuresEnd");
     this->Process(&alignMeasures, &alignMeasuresParams, &alignMeasuresEnd);
 }
 
 void Page::LayOutVertically()
 {
+    PROFILE_STAGE("Page::LayOutVertically");
+
     Doc *doc = dynamic_cast<Doc *>(GetParent());
     assert(doc);
 
@@ -281,68 +288,100 @@ void Page::LayOutVertically()
     // Make sure we have the correct page
     assert(this == doc->GetDrawingPage());
 
+    // Everything up to the rendering of the bounding boxes is local to each system
+    ProcessConcurrently(this->GetSystemCount(), [this, doc](int i) {
+        System *system = dynamic_cast<System *>(this->GetChild(i));
+        assert(system);
+        this->AlignSystemVertically(system, doc);
+    });
+
+    // Render it for filling the bounding box
+    View view;
+    view.SetDoc(doc);
+    // Do not do the layout in this view - otherwise we will loop...
+    view.SetPage(this->GetIdx(), false);
+    // Each system is rendered in its own device context, but sequentially because drawing changes the document fonts
+    // and the current positioner of time spanning elements that can be drawn in more than one system
+    for (int i = 0; i < this->GetSystemCount(); i++) {
+        System *system = dynamic_cast<System *>(this->GetChild(i));
+        assert(system);
+        BBoxDeviceContext bBoxDC(&view, 0, 0);
+        view.DrawCurrentPageSystem(&bBoxDC, system);
+    }
+
+    // The adjustments using the bounding boxes are also local to each system
+    ProcessConcurrently(this->GetSystemCount(), [this, doc](int i) {
+        System *system = dynamic_cast<System *>(this->GetChild(i));
+        assert(system);
+        this->AdjustSystemVertically(system, doc);
+    });
+
+    // Adjust system Y position
+    AlignSystemsParams alignSystemsParams;
+    alignSystemsParams.m_shift = doc->m_drawingPageHeight - doc->m_drawingPageTopMar;
+    alignSystemsParams.m_systemMargin = (doc->GetSpacingSystem()) * doc->GetDrawingUnit(100);
+    Functor alignSystems(&Object::AlignSystems, "AlignSystems");
+    this->Process(&alignSystems, &alignSystemsParams);
+}
+
+void Page::AlignSystemVertically(System *system, Doc *doc)
+{
+    assert(system);
+    assert(doc);
+
     // Reset the vertical alignment
-    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment);
-    this->Process(&resetVerticalAlignment, NULL);
+    Functor resetVerticalAlignment(&Object::ResetVerticalAlignment, "ResetVerticalAlignment");
+    system->Process(&resetVerticalAlignment, NULL);
 
     FunctorDocParams calcLegerLinesParams(doc);
-    Functor calcLedgerLines(&Object::CalcLedgerLines);
-    this->Process(&calcLedgerLines, &calcLegerLinesParams);
+    Functor calcLedgerLines(&Object::CalcLedgerLines, "CalcLedgerLines");
+    system->Process(&calcLedgerLines, &calcLegerLinesParams);
 
-    // Align the content of the page using system aligners
+    // Align the content of the system using its aligner
     // After this:
     // - each Staff object will then have its StaffAlignment pointer initialized
-    Functor alignVertically(&Object::AlignVertically);
-    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd);
+    Functor alignVertically(&Object::AlignVertically, "AlignVertically");
+    Functor alignVerticallyEnd(&Object::AlignVerticallyEnd, "AlignVerticallyEnd");
     AlignVerticallyParams alignVerticallyParams(doc, &alignVerticallyEnd);
-    this->Process(&alignVertically, &alignVerticallyParams, &alignVerticallyEnd);
+    system->Process(&alignVertically, &alignVerticallyParams, &alignVerticallyEnd);
 
     // Adjust the position of outside articulations
     FunctorDocParams calcArticParams(doc);
-    Functor calcArtic(&Object::CalcArtic);
-    this->Process(&calcArtic, &calcArticParams);
+    Functor calcArtic(&Object::CalcArtic, "CalcArtic");
+    system->Process(&calcArtic, &calcArticParams);
+}
 
-    // Render it for filling the bounding box
-    View view;
-    BBoxDeviceContext bBoxDC(&view, 0, 0);
-    view.SetDoc(doc);
-    // Do not do the layout in this view - otherwise we will loop...
-    view.SetPage(this->GetIdx(), false);
-    view.DrawCurrentPage(&bBoxDC, false);
+void Page::AdjustSystemVertically(System *system, Doc *doc)
+{
+    assert(system);
+    assert(doc);
 
     // Adjust the position of outside articulations with slurs end and start positions
     FunctorDocParams adjustArticWithSlursParams(doc);
-    Functor adjustArticWithSlurs(&Object::AdjustArticWithSlurs);
-    this->Process(&adjustArticWithSlurs, &adjustArticWithSlursParams);
+    Functor adjustArticWithSlurs(&Object::AdjustArticWithSlurs, "AdjustArticWithSlurs");
+    system->Process(&adjustArticWithSlurs, &adjustArticWithSlursParams);
 
     // Fill the arrays of bounding boxes (above and below) for each staff alignment for which the box overflows.
     SetOverflowBBoxesParams setOverflowBBoxesParams(doc);
-    Functor setOverflowBBoxes(&Object::SetOverflowBBoxes);
-    Functor setOverflowBBoxesEnd(&Object::SetOverflowBBoxesEnd);
-    this->Process(&setOverflowBBoxes, &setOverflowBBoxesParams, &setOverflowBBoxesEnd);
+    Functor setOverflowBBoxes(&Object::SetOverflowBBoxes, "SetOverflowBBoxes");
+    Functor setOverflowBBoxesEnd(&Object::SetOverflowBBoxesEnd, "SetOverflowBBoxesEnd");
+    system->Process(&setOverflowBBoxes, &setOverflowBBoxesParams, &setOverflowBBoxesEnd);
 
     // Adjust the positioners of floationg elements (slurs, hairpin, dynam, etc)
-    Functor adjustFloatingPostioners(&Object::AdjustFloatingPostioners);
+    Functor adjustFloatingPostioners(&Object::AdjustFloatingPostioners, "AdjustFloatingPostioners");
     AdjustFloatingPostionersParams adjustFloatingPostionersParams(doc, &adjustFloatingPostioners);
-    this->Process(&adjustFloatingPostioners, &adjustFloatingPostionersParams);
+    system->Process(&adjustFloatingPostioners, &adjustFloatingPostionersParams);
 
     // Adjust the overlap of the staff aligmnents by looking at the overflow bounding boxes params.clear();
-    Functor adjustStaffOverlap(&Object::AdjustStaffOverlap);
+    Functor adjustStaffOverlap(&Object::AdjustStaffOverlap, "AdjustStaffOverlap");
     AdjustStaffOverlapParams adjustStaffOverlapParams(&adjustStaffOverlap);
-    this->Process(&adjustStaffOverlap, &adjustStaffOverlapParams);
+    system->Process(&adjustStaffOverlap, &adjustStaffOverlapParams);
 
     // Set the Y position of each StaffAlignment
     // Adjust the Y shift to make sure there is a minimal space (staffMargin) between each staff
-    Functor adjustYPos(&Object::AdjustYPos);
+    Functor adjustYPos(&Object::AdjustYPos, "AdjustYPos");
     AdjustYPosParams adjustYPosParams(doc, &adjustYPos);
-    this->Process(&adjustYPos, &adjustYPosParams);
-
-    // Adjust system Y position
-    AlignSystemsParams alignSystemsParams;
-    alignSystemsParams.m_shift = doc->m_drawingPageHeight - doc->m_drawingPageTopMar;
-    alignSystemsParams.m_systemMargin = (doc->GetSpacingSystem()) * doc->GetDrawingUnit(100);
-    Functor alignSystems(&Object::AlignSystems);
-    this->Process(&alignSystems, &alignSystemsParams);
+    system->Process(&adjustYPos, &adjustYPosParams);
 }
 
 void Page::JustifyHorizontally()
@@ -359,7 +398,7 @@ void Page::JustifyHorizontally()
     assert(this == doc->GetDrawingPage());
 
     // Justify X position
-    Functor justifyX(&Object::JustifyX);
+    Functor justifyX(&Object::JustifyX, "JustifyX");
     JustifyXParams justifyXParams(&justifyX);
     justifyXParams.m_systemFullWidth = doc->m_drawingPageWidth - doc->m_drawingPageLeftMar - doc->m_drawingPageRightMar;
     this->Process(&justifyX, &justifyXParams);
@@ -376,11 +415,11 @@ void Page::LayOutPitchPos()
 
     // Set the pitch / pos alignement
     SetAlignmentPitchPosParams setAlignmentPitchPosParams(doc);
-    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos);
+    Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos, "SetAlignmentPitchPos");
     this->Process(&setAlignmentPitchPos, &setAlignmentPitchPosParams);
 
     CalcStemParams calcStemParams(doc);
-    Functor calcStem(&Object::CalcStem);
+    Functor calcStem(&Object::CalcStem, "CalcStem");
     this->Process(&calcStem, &calcStemParams);
 }
 
@@ -442,8 +481,8 @@ void Page::AdjustSylSpacingByVerse(PrepareProcessingListsParams &listsParams, Do
                 // The first pass sets m_drawingFirstNote and m_drawingLastNote for each syl
                 // m_drawingLastNote is set only if the syl has a forward connector
                 AdjustSylSpacingParams adjustSylSpacingParams(doc);
-                Functor adjustSylSpacing(&Object::AdjustSylSpacing);
-                Functor adjustSylSpacingEnd(&Object::AdjustSylSpacingEnd);
+                Functor adjustSylSpacing(&Object::AdjustSylSpacing, "AdjustSylSpacing");
+                Functor adjustSylSpacingEnd(&Object::AdjustSylSpacingEnd, "AdjustSylSpacingEnd");
                 this->Process(&adjustSylSpacing, &adjustSylSpacingParams, &adjustSylSpacingEnd, &filters);
             }
         }
@@ -0,0 +1,259 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        profiler.cpp
+// Author:      Verovio contributors
+// Created:     2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "profiler.h"
+
+//----------------------------------------------------------------------------
+
+#include <vector>
+
+#if defined(USE_PROFILING) && !defined(NO_THREAD_SUPPORT)
+#include <mutex>
+#include <thread>
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "vrv.h"
+
+namespace vrv {
+
+#ifdef USE_PROFILING
+
+//----------------------------------------------------------------------------
+// FunctorProfile
+//----------------------------------------------------------------------------
+
+FunctorProfile::FunctorProfile()
+{
+    m_processDepth = 0;
+    m_callDepth = 0;
+    Reset();
+}
+
+void FunctorProfile::Reset()
+{
+    m_visited = 0;
+    m_actedOn = 0;
+    m_classes.clear();
+}
+
+void FunctorProfile::AddCall(ClassId classId, const std::string &className, double time)
+{
+    std::map<ClassId, std::pair<std::string, std::pair<unsigned long long, double> > >::iterator iter
+        = m_classes.find(classId);
+    if (iter == m_classes.end()) {
+        iter = m_classes.insert(std::make_pair(classId, std::make_pair(className, std::make_pair(0ULL, 0.0)))).first;
+    }
+    iter->second.second.first++;
+    iter->second.second.second += time;
+}
+
+//----------------------------------------------------------------------------
+// ProfileScope
+//----------------------------------------------------------------------------
+
+ProfileScope::ProfileScope(const char *name)
+{
+    m_name = name;
+    m_start = std::chrono::steady_clock::now();
+}
+
+ProfileScope::~ProfileScope()
+{
+    Profiler::AddStage(m_name, m_start, std::chrono::steady_clock::now());
+}
+
+//----------------------------------------------------------------------------
+// Profile data
+//----------------------------------------------------------------------------
+
+/**
+ * The calls and the time (in ms) of a stage or of a class.
+ */
+typedef std::pair<unsigned long long, double> ProfileCount;
+
+/**
+ * What a functor did in all its passes.
+ */
+class ProfiledFunctor {
+public:
+    ProfiledFunctor() : m_passes(0), m_time(0.0), m_visited(0), m_actedOn(0) {}
+
+    unsigned long long m_passes;
+    double m_time;
+    unsigned long long m_visited;
+    unsigned long long m_actedOn;
+    std::map<std::string, ProfileCount> m_classes;
+};
+
+/**
+ * An event of the trace, with the times in microseconds from the beginning of the profile.
+ */
+class ProfileEvent {
+public:
+    std::string m_name;
+    const char *m_category;
+    double m_begin;
+    double m_duration;
+    int m_thread;
+};
+
+ProfileTime profileStart = std::chrono::steady_clock::now();
+std::map<std::string, ProfileCount> profileStages;
+std::map<std::string, ProfiledFunctor> profileFunctors;
+std::vector<ProfileEvent> profileEvents;
+
+#ifndef NO_THREAD_SUPPORT
+/** The stages and the functor passes are added from the threads started by ProcessConcurrently */
+std::mutex profileMutex;
+std::map<std::thread::id, int> profileThreads;
+#define PROFILE_LOCK std::lock_guard<std::mutex> lock(profileMutex);
+#else
+#define PROFILE_LOCK
+#endif
+
+/**
+ * Add an event to the trace - the lock has to be held.
+ */
+void AddProfileEvent(const char *name, const char *category, const ProfileTime &start, const ProfileTime &end)
+{
+    if (profileEvents.size() >= PROFILER_MAX_TRACE_EVENTS) return;
+
+    ProfileEvent event;
+    event.m_name = name;
+    event.m_category = category;
+    event.m_begin = std::chrono::duration<double, std::micro>(start - profileStart).count();
+    event.m_duration = std::chrono::duration<double, std::micro>(end - start).count();
+    event.m_thread = 1;
+#ifndef NO_THREAD_SUPPORT
+    // The threads are numbered in the order they appear
+    std::map<std::thread::id, int>::iterator iter = profileThreads.find(std::this_thread::get_id());
+    if (iter == profileThreads.end()) {
+        iter = profileThreads.insert(std::make_pair(std::this_thread::get_id(), (int)profileThreads.size() + 1)).first;
+    }
+    event.m_thread = iter->second;
+#endif
+    profileEvents.push_back(event);
+}
+
+#endif
+
+//----------------------------------------------------------------------------
+// Profiler
+//----------------------------------------------------------------------------
+
+bool Profiler::IsEnabled()
+{
+#ifdef USE_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::Reset()
+{
+#ifdef USE_PROFILING
+    PROFILE_LOCK
+
+    profileStart = std::chrono::steady_clock::now();
+    profileStages.clear();
+    profileFunctors.clear();
+    profileEvents.clear();
+#endif
+}
+
+#ifdef USE_PROFILING
+
+void Profiler::AddStage(const char *name, const ProfileTime &start, const ProfileTime &end)
+{
+    PROFILE_LOCK
+
+    ProfileCount &stage = profileStages[name];
+    stage.first++;
+    stage.second += std::chrono::duration<double, std::milli>(end - start).count();
+    AddProfileEvent(name, "stage", start, end);
+}
+
+void Profiler::AddFunctorPass(
+    const char *name, const FunctorProfile &profile, const ProfileTime &start, const ProfileTime &end)
+{
+    PROFILE_LOCK
+
+    // Functors created without a name are all added together
+    if (!name || !name[0]) name = "Functor";
+    ProfiledFunctor &functor = profileFunctors[name];
+    functor.m_passes++;
+    functor.m_time += std::chrono::duration<double, std::milli>(end - start).count();
+    functor.m_visited += profile.m_visited;
+    functor.m_actedOn += profile.m_actedOn;
+    std::map<ClassId, std::pair<std::string, std::pair<unsigned long long, double> > >::const_iterator iter;
+    for (iter = profile.m_classes.begin(); iter != profile.m_classes.end(); ++iter) {
+        ProfileCount &count = functor.m_classes[iter->second.first];
+        count.first += iter->second.second.first;
+        count.second += iter->second.second.second;
+    }
+    // The passes of the end functors have no time of their own and are not traced
+    if (end > start) AddProfileEvent(name, "functor", start, end);
+}
+
+#endif
+
+std::string Profiler::GetSummary()
+{
+#ifdef USE_PROFILING
+    PROFILE_LOCK
+
+    std::string json = "{\"enabled\": true, \"stages\": {";
+    std::map<std::string, ProfileCount>::iterator iter;
+    for (iter = profileStages.begin(); iter != profileStages.end(); ++iter) {
+        if (iter != profileStages.begin()) json += ", ";
+        json += StringFormat(
+            "\"%s\": {\"calls\": %llu, \"time\": %.3f}", iter->first.c_str(), iter->second.first, iter->second.second);
+    }
+    json += "}, \"functors\": {";
+    std::map<std::string, ProfiledFunctor>::iterator functorIter;
+    for (functorIter = profileFunctors.begin(); functorIter != profileFunctors.end(); ++functorIter) {
+        ProfiledFunctor &functor = functorIter->second;
+        if (functorIter != profileFunctors.begin()) json += ", ";
+        json += StringFormat("\"%s\": {\"passes\": %llu, \"time\": %.3f, \"visited\": %llu, \"actedOn\": %llu, "
+                             "\"classes\": {",
+            functorIter->first.c_str(), functor.m_passes, functor.m_time, functor.m_visited, functor.m_actedOn);
+        for (iter = functor.m_classes.begin(); iter != functor.m_classes.end(); ++iter) {
+            if (iter != functor.m_classes.begin()) json += ", ";
+            json += StringFormat("\"%s\": {\"calls\": %llu, \"time\": %.3f}", iter->first.c_str(), iter->second.first,
+                iter->second.second);
+        }
+        json += "}}";
+    }
+    json += "}}";
+    return json;
+#else
+    return "{\"enabled\": false}";
+#endif
+}
+
+std::string Profiler::GetTrace()
+{
+    std::string json = "{\"traceEvents\": [";
+#ifdef USE_PROFILING
+    PROFILE_LOCK
+
+    std::vector<ProfileEvent>::iterator iter;
+    for (iter = profileEvents.begin(); iter != profileEvents.end(); ++iter) {
+        if (iter != profileEvents.begin()) json += ",";
+        json += StringFormat("\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                             "\"pid\": 1, \"tid\": %d}",
+            iter->m_name.c_str(), iter->m_category, iter->m_begin, iter->m_duration, iter->m_thread);
+    }
+#endif
+    json += "\n], \"displayTimeUnit\": \"ms\"}\n";
+    return json;
+}
+
+} // namespace vrv
@@ -20,6 +20,7 @@
 #include "mensur.h"
 #include "metersig.h"
 #include "system.h"
+#include "timemap.h"
 #include "vrv.h"
 
 namespace vrv {
@@ -254,7 +255,7 @@ void ScoreDef::ReplaceDrawingValues(ScoreDef *newScoreDef)
     }
 
     ReplaceDrawingValuesInStaffDefParams replaceDrawingValuesInStaffDefParams(clef, keySig, mensur, meterSig);
-    Functor replaceDrawingValuesInScoreDef(&Object::ReplaceDrawingValuesInStaffDef);
+    Functor replaceDrawingValuesInScoreDef(&Object::ReplaceDrawingValuesInStaffDef, "ReplaceDrawingValuesInStaffDef");
     this->Process(&replaceDrawingValuesInScoreDef, &replaceDrawingValuesInStaffDefParams);
 
     if (clef) delete clef;
@@ -369,7 +370,7 @@ void ScoreDef::SetRedrawFlags(bool clef, bool keySig, bool mensur, bool meterSig
     setStaffDefRedrawFlagsParams.m_mensur = mensur;
     setStaffDefRedrawFlagsParams.m_meterSig = meterSig;
     setStaffDefRedrawFlagsParams.m_applyToAll = applyToAll;
-    Functor setStaffDefDraw(&Object::SetStaffDefRedrawFlags);
+    Functor setStaffDefDraw(&Object::SetStaffDefRedrawFlags, "SetStaffDefRedrawFlags");
     this->Process(&setStaffDefDraw, &setStaffDefRedrawFlagsParams);
 }
 
@@ -546,6 +547,19 @@ int ScoreDef::CastOffEncoding(FunctorParams *functorParams)
     return FUNCTOR_SIBLINGS;
 }
 
+int ScoreDef::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    // A tempo in a scoreDef changes it from the next measure
+    double bpm = Timemap::GetMidiTempoBpm(this);
+    if (bpm > 0.0) params->m_timemap->AddTempo((int)params->m_maxValues.size(), 0.0, bpm);
+
+    return FUNCTOR_CONTINUE;
+}
+
 //----------------------------------------------------------------------------
 // StaffDef functor methods
 //----------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 #include "page.h"
 #include "scoredef.h"
 #include "system.h"
+#include "timemap.h"
 #include "vrv.h"
 
 namespace vrv {
@@ -153,6 +154,18 @@ int Section::ResetDrawing(FunctorParams *functorParams)
     return FUNCTOR_CONTINUE;
 };
 
+int Section::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+    assert(params->m_timemap);
+
+    // The content of the section is between the section milestone and its end
+    if (this->IsBoundary()) params->m_timemap->StartSection(this->GetUuid());
+
+    return FUNCTOR_CONTINUE;
+}
+
 //----------------------------------------------------------------------------
 // Pb functor methods
 //----------------------------------------------------------------------------
@@ -734,7 +734,7 @@ void SvgDeviceContext::DrawMusicText(const std::wstring &text, int x, int y, boo
     // print chars one by one
     for (unsigned int i = 0; i < text.length(); i++) {
         wchar_t c = text.at(i);
-        Glyph *glyph = Resources::GetGlyph(c);
+        Glyph *glyph = m_musicFont->GetGlyph(c);
         if (!glyph) {
             continue;
         }
@@ -838,7 +838,7 @@ void SvgDeviceContext::DrawSvgBoundingBox(Object *object, View *view)
 
         for (iter = anchors.begin(); iter != anchors.end(); iter++) {
             if (object->GetBoundingBoxGlyph() != 0) {
-                Glyph *glyph = Resources::GetGlyph(object->GetBoundingBoxGlyph());
+                Glyph *glyph = m_musicFont->GetGlyph(object->GetBoundingBoxGlyph());
                 assert(glyph);
 
                 if (glyph->HasAnchor(*iter)) {
@@ -71,6 +71,7 @@ void System::Reset()
     m_drawingJustifiableWidth = 0;
     m_drawingLabelsWidth = 0;
     m_drawingAbbrLabelsWidth = 0;
+    m_castOffScoreDefWidth = 0;
 }
 
 void System::AddChild(Object *child)
@@ -347,7 +348,7 @@ int System::AdjustFloatingPostioners(FunctorParams *functorParams)
     assert(params);
 
     AdjustFloatingPostionerGrpsParams adjustFloatingPostionerGrpsParams(params->m_doc);
-    Functor adjustFloatingPostionerGrps(&Object::AdjustFloatingPostionerGrps);
+    Functor adjustFloatingPostionerGrps(&Object::AdjustFloatingPostionerGrps, "AdjustFloatingPostionerGrps");
 
     params->m_classId = TIE;
     m_systemAligner.Process(params->m_functor, params);
@@ -15,7 +15,11 @@
 
 #include "controlelement.h"
 #include "editorial.h"
+#include "functorparams.h"
+#include "horizontalaligner.h"
+#include "layerelement.h"
 #include "text.h"
+#include "timemap.h"
 #include "vrv.h"
 
 namespace vrv {
@@ -68,4 +72,28 @@ void Tempo::AddChild(Object *child)
     Modify();
 }
 
+//----------------------------------------------------------------------------
+// Tempo functor methods
+//----------------------------------------------------------------------------
+
+int Tempo::CalcMaxMeasureDuration(FunctorParams *functorParams)
+{
+    CalcMaxMeasureDurationParams *params = dynamic_cast<CalcMaxMeasureDurationParams *>(functorParams);
+    assert(params);
+
+    double bpm = Timemap::GetMidiTempoBpm(this);
+    if ((bpm <= 0.0) || params->m_maxValues.empty()) return FUNCTOR_CONTINUE;
+
+    // The tempo changes at the time of its start within the measure
+    double time = 0.0;
+    LayerElement *start = this->GetStart();
+    if (start && start->GetAlignment()) {
+        time = start->GetAlignment()->GetTime() * params->m_currentBpm / (DUR_MAX / DURATION_4);
+    }
+    // The tempo change is added to the timemap with the measure
+    params->m_measureTempos.push_back(std::make_pair(time, bpm));
+
+    return FUNCTOR_CONTINUE;
+}
+
 } // namespace vrv
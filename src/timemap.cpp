@@ -0,0 +1,292 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        timemap.cpp
+// Author:      Verovio contributors
+// Created:     2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include "timemap.h"
+
+//----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <assert.h>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+
+#include "vrv.h"
+
+namespace vrv {
+
+//----------------------------------------------------------------------------
+// Timemap
+//----------------------------------------------------------------------------
+
+Timemap::Timemap()
+{
+    Reset();
+}
+
+Timemap::~Timemap()
+{
+}
+
+void Timemap::Reset()
+{
+    m_structure.clear();
+    m_openSections.clear();
+    m_measureCount = 0;
+    m_tempos.clear();
+
+    m_scoreTimes.clear();
+    m_performanceTimes.clear();
+    m_performedMeasures.clear();
+    m_performedTimes.clear();
+
+    m_tempoTimes.clear();
+    m_tempoRealTimes.clear();
+    m_tempoBpms.clear();
+}
+
+void Timemap::AddMeasure(const std::string &uuid)
+{
+    m_structure.push_back(std::make_tuple(TIMEMAP_MEASURE, m_measureCount, uuid));
+    m_measureCount++;
+}
+
+void Timemap::StartSection(const std::string &uuid)
+{
+    m_openSections.push_back((int)m_structure.size());
+    // The index of the end is set when the section is closed
+    m_structure.push_back(std::make_tuple(TIMEMAP_SECTION_START, VRV_UNSET, uuid));
+}
+
+void Timemap::EndSection()
+{
+    if (m_openSections.empty()) return;
+
+    std::get<1>(m_structure.at(m_openSections.back())) = (int)m_structure.size();
+    m_openSections.pop_back();
+    m_structure.push_back(std::make_tuple(TIMEMAP_SECTION_END, VRV_UNSET, ""));
+}
+
+void Timemap::AddExpansion(const std::string &plist)
+{
+    m_structure.push_back(std::make_tuple(TIMEMAP_EXPANSION, VRV_UNSET, plist));
+}
+
+void Timemap::AddTempo(int measureIdx, double time, double bpm)
+{
+    if (bpm <= 0.0) return;
+
+    m_tempos.push_back(std::make_tuple(measureIdx, time, bpm));
+}
+
+void Timemap::Build(const std::vector<double> &measureDurations, double bpm)
+{
+    int i;
+
+    // Sections that are not closed end with the document
+    while (!m_openSections.empty()) {
+        std::get<1>(m_structure.at(m_openSections.back())) = (int)m_structure.size();
+        m_openSections.pop_back();
+    }
+
+    // The score time of the measures in document order
+    m_scoreTimes.clear();
+    double scoreTime = 0.0;
+    std::vector<double>::const_iterator iter;
+    for (iter = measureDurations.begin(); iter != measureDurations.end(); ++iter) {
+        m_scoreTimes.push_back(scoreTime);
+        scoreTime += (*iter);
+    }
+    int measureCount = (int)m_scoreTimes.size();
+
+    // The measures in performance order and their performance time
+    std::vector<int> order;
+    this->UnrollSection(0, (int)m_structure.size(), order);
+    m_performanceTimes.assign(measureCount, std::vector<double>());
+    m_performedMeasures.clear();
+    m_performedTimes.clear();
+    double performanceTime = 0.0;
+    std::vector<int>::iterator measureIter;
+    for (measureIter = order.begin(); measureIter != order.end(); ++measureIter) {
+        if ((*measureIter) >= measureCount) continue;
+        m_performanceTimes.at(*measureIter).push_back(performanceTime);
+        m_performedMeasures.push_back(*measureIter);
+        m_performedTimes.push_back(performanceTime);
+        performanceTime += measureDurations.at(*measureIter);
+    }
+
+    // The tempo changes sorted by their position in the score
+    std::stable_sort(m_tempos.begin(), m_tempos.end(),
+        [](const std::tuple<int, double, double> &tempo1, const std::tuple<int, double, double> &tempo2) {
+            if (std::get<0>(tempo1) != std::get<0>(tempo2)) return (std::get<0>(tempo1) < std::get<0>(tempo2));
+            return (std::get<1>(tempo1) < std::get<1>(tempo2));
+        });
+
+    // The tempo at the beginning of each measure and the first tempo change within it
+    std::vector<double> measureBpms(measureCount, bpm);
+    std::vector<int> measureTempos(measureCount + 1, (int)m_tempos.size());
+    double currentBpm = bpm;
+    int tempoIdx = 0;
+    for (i = 0; i < measureCount; i++) {
+        while ((tempoIdx < (int)m_tempos.size()) && (std::get<0>(m_tempos.at(tempoIdx)) < i)) {
+            currentBpm = std::get<2>(m_tempos.at(tempoIdx));
+            tempoIdx++;
+        }
+        measureBpms.at(i) = currentBpm;
+        measureTempos.at(i) = tempoIdx;
+    }
+
+    // The tempo changes in performance order - a measure reached by a jump is played with the tempo of its position in
+    // the score
+    m_tempoTimes.clear();
+    m_tempoRealTimes.clear();
+    m_tempoBpms.clear();
+    m_tempoTimes.push_back(0.0);
+    m_tempoRealTimes.push_back(0.0);
+    m_tempoBpms.push_back(bpm);
+    int previousMeasure = -1;
+    for (i = 0; i < (int)m_performedMeasures.size(); i++) {
+        int measureIdx = m_performedMeasures.at(i);
+        if (measureIdx != previousMeasure + 1) {
+            this->AddTempoChange(m_performedTimes.at(i), measureBpms.at(measureIdx));
+        }
+        for (tempoIdx = measureTempos.at(measureIdx); tempoIdx < measureTempos.at(measureIdx + 1); tempoIdx++) {
+            double time = std::min(std::get<1>(m_tempos.at(tempoIdx)), measureDurations.at(measureIdx));
+            this->AddTempoChange(m_performedTimes.at(i) + time, std::get<2>(m_tempos.at(tempoIdx)));
+        }
+        previousMeasure = measureIdx;
+    }
+}
+
+void Timemap::UnrollSection(int begin, int end, std::vector<int> &order) const
+{
+    int i, j;
+
+    // Look for an expansion in the section itself (not in the sections it contains)
+    const std::string *plist = NULL;
+    for (i = begin; i < end; i++) {
+        int type = std::get<0>(m_structure.at(i));
+        if (type == TIMEMAP_SECTION_START) {
+            i = std::get<1>(m_structure.at(i));
+        }
+        else if (type == TIMEMAP_EXPANSION) {
+            plist = &std::get<2>(m_structure.at(i));
+            break;
+        }
+    }
+
+    // Without expansion, everything is played in document order
+    if (!plist) {
+        for (i = begin; i < end; i++) {
+            int type = std::get<0>(m_structure.at(i));
+            if (type == TIMEMAP_MEASURE) {
+                order.push_back(std::get<1>(m_structure.at(i)));
+            }
+            else if (type == TIMEMAP_SECTION_START) {
+                this->UnrollSection(i + 1, std::get<1>(m_structure.at(i)), order);
+                i = std::get<1>(m_structure.at(i));
+            }
+        }
+        return;
+    }
+
+    // Otherwise only the sections and measures referred to are played, as many times as they are referred to
+    // Since they have to be within the section, the recursion always ends
+    std::istringstream iss(*plist);
+    std::string ref;
+    while (iss >> ref) {
+        if (ref.compare(0, 1, "#") == 0) ref = ref.substr(1);
+        for (j = begin; j < end; j++) {
+            if (std::get<2>(m_structure.at(j)) != ref) continue;
+            int type = std::get<0>(m_structure.at(j));
+            if (type == TIMEMAP_MEASURE) {
+                order.push_back(std::get<1>(m_structure.at(j)));
+                break;
+            }
+            else if (type == TIMEMAP_SECTION_START) {
+                this->UnrollSection(j + 1, std::get<1>(m_structure.at(j)), order);
+                break;
+            }
+        }
+        if (j == end) {
+            LogWarning("Element '%s' in the expansion could not be found", ref.c_str());
+        }
+    }
+}
+
+void Timemap::AddTempoChange(double performanceTime, double bpm)
+{
+    assert(!m_tempoTimes.empty());
+
+    if (bpm == m_tempoBpms.back()) return;
+
+    // A change at the same time replaces the previous one
+    if (performanceTime <= m_tempoTimes.back()) {
+        m_tempoBpms.back() = bpm;
+        return;
+    }
+
+    m_tempoRealTimes.push_back(this->GetRealTimeForPerformanceTime(performanceTime));
+    m_tempoTimes.push_back(performanceTime);
+    m_tempoBpms.push_back(bpm);
+}
+
+double Timemap::GetRealTimeForPerformanceTime(double performanceTime) const
+{
+    if (m_tempoTimes.empty()) {
+        return performanceTime * 60000.0 / (TIMEMAP_DEFAULT_BPM * TIMEMAP_TICKS_PER_QUARTER);
+    }
+
+    int idx = (int)(std::upper_bound(m_tempoTimes.begin(), m_tempoTimes.end(), performanceTime) - m_tempoTimes.begin());
+    idx = std::max(idx - 1, 0);
+
+    return m_tempoRealTimes.at(idx)
+        + (performanceTime - m_tempoTimes.at(idx)) * 60000.0 / (m_tempoBpms.at(idx) * TIMEMAP_TICKS_PER_QUARTER);
+}
+
+double Timemap::GetRealTimeForScoreTime(double scoreTime) const
+{
+    if (m_scoreTimes.empty()) return this->GetRealTimeForPerformanceTime(scoreTime);
+
+    int measureIdx = (int)(std::upper_bound(m_scoreTimes.begin(), m_scoreTimes.end(), scoreTime) - m_scoreTimes.begin());
+    measureIdx = std::max(measureIdx - 1, 0);
+    if (m_performanceTimes.at(measureIdx).empty()) return 0.0;
+
+    double performanceTime = m_performanceTimes.at(measureIdx).front() + scoreTime - m_scoreTimes.at(measureIdx);
+    return this->GetRealTimeForPerformanceTime(performanceTime);
+}
+
+double Timemap::GetMidiTempoBpm(const AttMiditempo *midiTempo)
+{
+    assert(midiTempo);
+
+    if (midiTempo->HasMidiBpm()) return midiTempo->GetMidiBpm();
+    if (midiTempo->HasMidiMspb() && (midiTempo->GetMidiMspb() > 0)) return 60000000.0 / midiTempo->GetMidiMspb();
+    return 0.0;
+}
+
+double Timemap::GetScoreTimeForRealTime(double realTime) const
+{
+    double performanceTime = realTime * TIMEMAP_DEFAULT_BPM * TIMEMAP_TICKS_PER_QUARTER / 60000.0;
+    if (!m_tempoRealTimes.empty()) {
+        int idx = (int)(std::upper_bound(m_tempoRealTimes.begin(), m_tempoRealTimes.end(), realTime)
+            - m_tempoRealTimes.begin());
+        idx = std::max(idx - 1, 0);
+        performanceTime = m_tempoTimes.at(idx)
+            + (realTime - m_tempoRealTimes.at(idx)) * m_tempoBpms.at(idx) * TIMEMAP_TICKS_PER_QUARTER / 60000.0;
+    }
+
+    if (m_performedTimes.empty()) return performanceTime;
+
+    int idx = (int)(std::upper_bound(m_performedTimes.begin(), m_performedTimes.end(), performanceTime)
+        - m_performedTimes.begin());
+    idx = std::max(idx - 1, 0);
+
+    return m_scoreTimes.at(m_performedMeasures.at(idx)) + performanceTime - m_performedTimes.at(idx);
+}
+
+} // namespace vrv
@@ -9,11 +9,15 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
+#include <cstdio>
+#include <sstream>
 
 //----------------------------------------------------------------------------
 
 #include "attcomparison.h"
+#include "editorial.h"
 #include "iodarms.h"
 #include "iohumdrum.h"
 #include "iomei.h"
@@ -43,7 +47,6 @@ const char *UTF_16_LE_BOM = "\xFF\xFE";
 // Toolkit
 //----------------------------------------------------------------------------
 
-char *Toolkit::m_humdrumBuffer = NULL;
 
 Toolkit::Toolkit(bool initFont)
 {
@@ -60,6 +63,7 @@ Toolkit::Toolkit(bool initFont)
     m_spacingSystem = DEFAULT_SPACING_SYSTEM;
 
     m_noLayout = false;
+    m_incrementalLayout = false;
     m_ignoreLayout = false;
     m_adjustPageHeight = false;
     m_noJustification = false;
@@ -67,30 +71,29 @@ Toolkit::Toolkit(bool initFont)
     m_showBoundingBoxes = false;
     m_scoreBasedMei = false;
 
-    m_cString = NULL;
-    m_humdrumBuffer = NULL;
+    m_layoutFont = NULL;
+    m_layoutIncremental = false;
+    m_layoutFromEncoding = false;
+
+    m_svgCacheSize = 0;
+    m_svgCacheBytes = 0;
 
     if (initFont) {
         Resources::InitFonts();
+        m_doc.SetMusicFont(Resources::GetDefaultMusicFont());
     }
 }
 
 Toolkit::~Toolkit()
 {
-    if (m_cString) {
-        free(m_cString);
-        m_cString = NULL;
-    }
-    if (m_humdrumBuffer) {
-        free(m_humdrumBuffer);
-        m_humdrumBuffer = NULL;
-    }
 }
 
 bool Toolkit::SetResourcePath(const std::string &path)
 {
     Resources::SetPath(path);
-    return Resources::InitFonts();
+    if (!Resources::InitFonts()) return false;
+    m_doc.SetMusicFont(Resources::GetDefaultMusicFont());
+    return true;
 };
 
 bool Toolkit::SetBorder(int border)
@@ -182,6 +185,17 @@ bool Toolkit::SetSpacingNonLinear(float spacingNonLinear)
     return true;
 }
 
+void Toolkit::SetSvgCacheSize(int size)
+{
+    m_svgCacheSize = std::max(size, 0);
+    // Remove the pages exceeding the new size
+    while (!m_svgCache.empty() && (m_svgCacheBytes > (size_t)m_svgCacheSize * 1024 * 1024)) {
+        m_svgCacheBytes -= m_svgCache.back().second.size();
+        m_svgCacheIndex.erase(m_svgCache.back().first);
+        m_svgCache.pop_back();
+    }
+}
+
 bool Toolkit::SetOutputFormat(std::string const &outformat)
 {
     if (outformat == "humdrum") {
@@ -328,7 +342,11 @@ FileFormat Toolkit::IdentifyInputFormat(const string &data)
 
 bool Toolkit::SetFont(std::string const &font)
 {
-    return Resources::SetFont(font);
+    // Only the font of the document is changed, the other toolkits are not affected
+    MusicFont *musicFont = Resources::GetMusicFont(font);
+    if (!musicFont) return false;
+    m_doc.SetMusicFont(musicFont);
+    return true;
 };
 
 bool Toolkit::LoadFile(const std::string &filename)
@@ -409,6 +427,8 @@ bool Toolkit::LoadData(const std::string &data)
     string newData;
     FileInputStream *input = NULL;
 
+    this->ClearSvgCache();
+
     auto inputFormat = m_format;
     if (inputFormat == AUTO) {
         inputFormat = IdentifyInputFormat(data);
@@ -438,9 +458,11 @@ bool Toolkit::LoadData(const std::string &data)
             return false;
         }
 
-        SetHumdrumBuffer(tempinput->GetHumdrumString().c_str());
+        // The filters have already been applied by the HumdrumInput
+        m_humdrumBuffer = tempinput->GetHumdrumString();
 
         if (GetOutputFormat() == HUMDRUM) {
+            delete tempinput;
             return true;
         }
 
@@ -471,18 +493,17 @@ bool Toolkit::LoadData(const std::string &data)
             LogError("Error converting MusicXML");
             return false;
         }
-        std::string buffer = conversion.str();
-        SetHumdrumBuffer(buffer.c_str());
 
         // Now convert Humdrum into MEI:
         Doc tempdoc;
-        FileInputStream *tempinput = new HumdrumInput(&tempdoc, "");
+        HumdrumInput *tempinput = new HumdrumInput(&tempdoc, "");
         tempinput->SetTypeOption(GetHumType());
         if (!tempinput->ImportString(conversion.str())) {
             LogError("Error importing Humdrum data");
             delete tempinput;
             return false;
         }
+        m_humdrumBuffer = tempinput->GetHumdrumString();
         MeiOutput meioutput(&tempdoc, "");
         meioutput.SetScoreBasedMEI(true);
         newData = meioutput.GetOutput();
@@ -513,12 +534,18 @@ bool Toolkit::LoadData(const std::string &data)
     }
 
     // load the file
-    if (!input->ImportString(newData.size() ? newData : data)) {
+    this->CallStageHook(TOOLKIT_STAGE_PARSE, -1, false);
+    bool imported = input->ImportString(newData.size() ? newData : data);
+    this->CallStageHook(TOOLKIT_STAGE_PARSE, -1, true);
+    if (!imported) {
         LogError("Error importing data");
         delete input;
         return false;
     }
 
+    // The default font is used if the fonts were not initialized when the toolkit was created
+    if (!m_doc.GetMusicFont()) m_doc.SetMusicFont(Resources::GetDefaultMusicFont());
+
     m_doc.SetPageHeight(this->GetPageHeight());
     m_doc.SetPageWidth(this->GetPageWidth());
     m_doc.SetPageRightMar(this->GetBorder());
@@ -530,23 +557,39 @@ bool Toolkit::LoadData(const std::string &data)
     m_doc.SetSpacingSystem(this->GetSpacingSystem());
     m_doc.SetEvenSpacing(this->GetEvenNoteSpacing());
 
+    this->CallStageHook(TOOLKIT_STAGE_PREPARE_DRAWING, -1, false);
     m_doc.PrepareDrawing();
+    this->CallStageHook(TOOLKIT_STAGE_PREPARE_DRAWING, -1, true);
 
     // Do the layout? this depends on the options and the file. PAE and
     // DARMS have no layout information. MEI files _can_ have it, but it
     // might have been ignored because of the --ignore-layout option.
     // Regardless, we won't do layout if the --no-layout option was set.
+    m_layoutFromEncoding = false;
     if (!m_noLayout) {
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, false);
         if (input->HasLayoutInformation() && !m_ignoreLayout) {
             // LogElapsedTimeStart();
             m_doc.CastOffEncodingDoc();
+            m_layoutFromEncoding = true;
             // LogElapsedTimeEnd("layout");
         }
+        else if (m_incrementalLayout) {
+            m_doc.CastOffDocIncrementally();
+        }
         else {
-            // LogElapsedTimeStart();
-            m_doc.CastOffDoc();
-            // LogElapsedTimeEnd("layout");
+            std::string layoutCacheFile = m_layoutCacheDir.empty() ? "" : this->GetLayoutCacheFile(data);
+            if (!layoutCacheFile.empty() && this->CastOffFromLayoutCache(layoutCacheFile)) {
+                // The layout calculated for the same data and options could be used
+            }
+            else {
+                // LogElapsedTimeStart();
+                m_doc.CastOffDoc();
+                // LogElapsedTimeEnd("layout");
+                if (!layoutCacheFile.empty()) this->AddToLayoutCache(layoutCacheFile);
+            }
         }
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, true);
     }
 
     // disable justification if there's no layout or no justification
@@ -554,17 +597,181 @@ bool Toolkit::LoadData(const std::string &data)
         m_doc.SetJustificationX(false);
     }
 
+    m_layoutFont = m_doc.GetMusicFont();
+    m_layoutIncremental = m_incrementalLayout;
+
     delete input;
     m_view.SetDoc(&m_doc);
 
     return true;
 }
 
+std::string Toolkit::GetLayoutCacheFile(const std::string &data)
+{
+    // The data and the options used for loading it
+    unsigned long long hash = HashData(data);
+    hash = HashData(StringFormat("%d;%d;%s", m_format, m_humType, m_mdivXPathQuery.c_str()), hash);
+    std::vector<std::string>::iterator iter;
+    for (iter = m_appXPathQueries.begin(); iter != m_appXPathQueries.end(); ++iter) {
+        hash = HashData("app;" + (*iter), hash);
+    }
+    for (iter = m_choiceXPathQueries.begin(); iter != m_choiceXPathQueries.end(); ++iter) {
+        hash = HashData("choice;" + (*iter), hash);
+    }
+
+    // The layout options, which are also checked when the layout is applied
+    hash = HashData(StringFormat("%d;%d;%d;%d;%d;%f;%f;%d;%s;%s", m_pageHeight, m_pageWidth, m_border, m_spacingStaff,
+                        m_spacingSystem, m_spacingLinear, m_spacingNonLinear, m_evenNoteSpacing,
+                        m_doc.GetMusicFont()->GetName().c_str(), GetVersion().c_str()),
+        hash);
+
+    std::string separator = (m_layoutCacheDir.back() == '/') ? "" : "/";
+    return StringFormat("%s%s%016llx.layout", m_layoutCacheDir.c_str(), separator.c_str(), hash);
+}
+
+bool Toolkit::CastOffFromLayoutCache(const std::string &filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::in);
+    if (!in.is_open()) return false;
+
+    // The header has the version of the cache file, of Verovio and the font the layout was calculated with
+    std::string magic, version, font;
+    int cacheVersion = 0;
+    in >> magic >> cacheVersion >> version >> font;
+    if ((magic != "VRVLAYOUTCACHE") || (cacheVersion != 1) || (version != GetVersion())
+        || (font != m_doc.GetMusicFont()->GetName())) {
+        return false;
+    }
+
+    std::vector<int> systemsPerPage;
+    std::vector<int> childrenPerSystem;
+    std::vector<std::string> pageUuids;
+    std::vector<std::string> systemUuids;
+    int pageCount = 0;
+    in >> pageCount;
+    int i, j;
+    for (i = 0; in.good() && (i < pageCount); i++) {
+        std::string uuid;
+        int systemCount = 0;
+        in >> uuid >> systemCount;
+        pageUuids.push_back(uuid);
+        systemsPerPage.push_back(systemCount);
+        for (j = 0; in.good() && (j < systemCount); j++) {
+            int childCount = 0;
+            in >> uuid >> childCount;
+            systemUuids.push_back(uuid);
+            childrenPerSystem.push_back(childCount);
+        }
+    }
+    if (in.fail() || systemsPerPage.empty()) return false;
+
+    if (!m_doc.CastOffLayoutDoc(systemsPerPage, childrenPerSystem, pageUuids, systemUuids)) {
+        LogWarning("The layout in the cache does not match the content, the layout will be redone");
+        return false;
+    }
+
+    return true;
+}
+
+void Toolkit::AddToLayoutCache(const std::string &filename)
+{
+    // The file is written under a temporary name first so that it is never read before being complete
+    std::string tempFilename = StringFormat(
+        "%s.%016llx.tmp", filename.c_str(), HashData(StringFormat("%p;%ld", (void *)this, (long)time(NULL))));
+    std::ofstream out(tempFilename.c_str(), std::ios::out);
+    if (!out.is_open()) return;
+
+    // The page and system breaks as the number of children of each page and system
+    out << "VRVLAYOUTCACHE 1 " << GetVersion() << " " << m_doc.GetMusicFont()->GetName() << "\n";
+    out << m_doc.GetChildCount() << "\n";
+    int i, j;
+    for (i = 0; i < m_doc.GetChildCount(); i++) {
+        Object *page = m_doc.GetChild(i);
+        assert(page && page->Is(PAGE));
+        out << page->GetUuid() << " " << page->GetChildCount() << "\n";
+        for (j = 0; j < page->GetChildCount(); j++) {
+            Object *system = page->GetChild(j);
+            assert(system && system->Is(SYSTEM));
+            out << system->GetUuid() << " " << system->GetChildCount() << "\n";
+        }
+    }
+    out.close();
+
+    if (out.fail() || (std::rename(tempFilename.c_str(), filename.c_str()) != 0)) {
+        std::remove(tempFilename.c_str());
+    }
+}
+
+bool Toolkit::IndexMdivs(const std::string &data)
+{
+    m_mdivData.clear();
+    m_mdivIndex.Reset();
+
+    if (IdentifyInputFormat(data) != MEI) {
+        LogError("Only the <mdiv> of MEI data can be indexed");
+        return false;
+    }
+    if (!m_mdivIndex.Scan(data)) return false;
+    m_mdivData = data;
+
+    return true;
+}
+
+bool Toolkit::LoadMdiv(int idx)
+{
+    if ((idx < 0) || (idx >= m_mdivIndex.GetMdivCount())) {
+        LogError("The <mdiv> %d is not in the index", idx);
+        return false;
+    }
+
+    // The data has only the <mdiv> to be loaded, which cannot be selected again with the xPath query
+    FileFormat format = m_format;
+    std::string mdivXPathQuery = m_mdivXPathQuery;
+    m_format = MEI;
+    m_mdivXPathQuery = "";
+    bool success = this->LoadData(m_mdivIndex.Extract(m_mdivData, idx));
+    m_format = format;
+    m_mdivXPathQuery = mdivXPathQuery;
+
+    return success;
+}
+
+std::string Toolkit::GetMdivIndex()
+{
+#if defined(USE_EMSCRIPTEN) || defined(PYTHON_BINDING)
+    jsonxx::Array mdivs;
+
+    int i;
+    for (i = 0; i < m_mdivIndex.GetMdivCount(); i++) {
+        jsonxx::Object mdiv;
+        mdiv << "n" << m_mdivIndex.GetN(i);
+        mdiv << "label" << m_mdivIndex.GetLabel(i);
+        mdiv << "id" << m_mdivIndex.GetId(i);
+        mdiv << "level" << m_mdivIndex.GetLevel(i);
+        mdiv << "parent" << m_mdivIndex.GetParent(i);
+        mdiv << "begin" << (double)m_mdivIndex.GetBegin(i);
+        mdiv << "end" << (double)m_mdivIndex.GetEnd(i);
+        mdivs << mdiv;
+    }
+
+    return mdivs.json();
+
+#else
+    // The non-js version of the app should not use this function.
+    return "";
+#endif
+}
+
 std::string Toolkit::GetMEI(int pageNo, bool scoreBased)
 {
     // Page number is one-based - correct it to 0-based first
     pageNo--;
 
+    if (!scoreBased) {
+        this->UpdateLayout(this->GetInvalidatedStage(), true);
+        m_doc.CastOffPendingPages();
+    }
+
     MeiOutput meioutput(&m_doc, "");
     meioutput.SetScoreBasedMEI(scoreBased);
     return meioutput.GetOutput(pageNo);
@@ -572,6 +779,11 @@ std::string Toolkit::GetMEI(int pageNo, bool scoreBased)
 
 bool Toolkit::SaveFile(const std::string &filename)
 {
+    if (!m_scoreBasedMei) {
+        this->UpdateLayout(this->GetInvalidatedStage(), true);
+        m_doc.CastOffPendingPages();
+    }
+
     MeiOutput meioutput(&m_doc, filename.c_str());
     meioutput.SetScoreBasedMEI(m_scoreBasedMei);
     if (!meioutput.ExportFile()) {
@@ -655,6 +867,9 @@ bool Toolkit::ParseOptions(const std::string &json_options)
 
     if (json.has<jsonxx::Number>("ignoreLayout")) SetIgnoreLayout(json.get<jsonxx::Number>("ignoreLayout"));
 
+    if (json.has<jsonxx::Number>("incrementalLayout"))
+        SetIncrementalLayout(json.get<jsonxx::Number>("incrementalLayout"));
+
     if (json.has<jsonxx::Number>("adjustPageHeight")) SetAdjustPageHeight(json.get<jsonxx::Number>("adjustPageHeight"));
 
     if (json.has<jsonxx::Number>("noJustification")) SetNoJustification(json.get<jsonxx::Number>("noJustification"));
@@ -666,6 +881,10 @@ bool Toolkit::ParseOptions(const std::string &json_options)
     if (json.has<jsonxx::Number>("showBoundingBoxes"))
         SetShowBoundingBoxes(json.get<jsonxx::Number>("showBoundingBoxes"));
 
+    if (json.has<jsonxx::Number>("svgCacheSize")) SetSvgCacheSize(json.get<jsonxx::Number>("svgCacheSize"));
+
+    if (json.has<jsonxx::String>("layoutCacheDir")) SetLayoutCacheDir(json.get<jsonxx::String>("layoutCacheDir"));
+
     return true;
 #else
     // The non-js version of the app should not use this function.
@@ -776,22 +995,134 @@ void Toolkit::ResetLogBuffer()
 #endif
 }
 
+std::string Toolkit::GetProfile()
+{
+    return Profiler::GetSummary();
+}
+
+void Toolkit::ResetProfile()
+{
+    Profiler::Reset();
+}
+
 void Toolkit::RedoLayout()
 {
-    if (m_doc.GetType() == Transcription) {
+    OptionsStage stage = this->GetInvalidatedStage();
+    // Without any option changed, everything is redone
+    this->UpdateLayout((stage == OPTIONS_NONE) ? OPTIONS_CASTOFF : stage);
+}
+
+OptionsStage Toolkit::GetInvalidatedStage()
+{
+    // The values are compared with the ones stored in the document when it was laid out
+    int border = this->GetBorder() * DEFINITION_FACTOR;
+    if ((m_doc.GetPageWidth() != this->GetPageWidth() * DEFINITION_FACTOR) || (m_doc.GetPageLeftMar() != border)
+        || (m_doc.GetPageRightMar() != border) || (m_doc.GetPageTopMar() != border)
+        || (m_doc.GetSpacingLinear() != this->GetSpacingLinear())
+        || (m_doc.GetSpacingNonLinear() != this->GetSpacingNonLinear())
+        || (m_doc.GetEvenSpacing() != (bool)this->GetEvenNoteSpacing()) || (m_layoutFont != m_doc.GetMusicFont())
+        || (m_layoutIncremental != m_incrementalLayout)) {
+        return OPTIONS_CASTOFF;
+    }
+
+    if ((m_doc.GetPageHeight() != this->GetPageHeight() * DEFINITION_FACTOR)
+        || (m_doc.GetSpacingStaff() != this->GetSpacingStaff())
+        || (m_doc.GetSpacingSystem() != this->GetSpacingSystem())
+        || (m_doc.GetJustificationX() == (m_noLayout || m_noJustification))) {
+        return OPTIONS_VERTICAL;
+    }
+
+    return OPTIONS_NONE;
+}
+
+void Toolkit::UpdateLayout(OptionsStage stage, bool keepEncodedBreaks)
+{
+    if ((stage == OPTIONS_NONE) || (m_doc.GetChildCount() == 0) || (m_doc.GetType() == Transcription)) {
         return;
     }
 
+    // The default font is used if the fonts were not initialized when the toolkit was created
+    if (!m_doc.GetMusicFont()) m_doc.SetMusicFont(Resources::GetDefaultMusicFont());
+
     m_doc.SetPageHeight(this->GetPageHeight());
     m_doc.SetPageWidth(this->GetPageWidth());
     m_doc.SetPageRightMar(this->GetBorder());
     m_doc.SetPageLeftMar(this->GetBorder());
     m_doc.SetPageTopMar(this->GetBorder());
+    m_doc.SetSpacingLinear(this->GetSpacingLinear());
+    m_doc.SetSpacingNonLinear(this->GetSpacingNonLinear());
     m_doc.SetSpacingStaff(this->GetSpacingStaff());
     m_doc.SetSpacingSystem(this->GetSpacingSystem());
+    m_doc.SetEvenSpacing(this->GetEvenNoteSpacing());
+    m_doc.SetJustificationX(!m_noLayout && !m_noJustification);
+
+    if (keepEncodedBreaks && m_layoutFromEncoding && !m_noLayout) {
+        // The pages and the systems of the encoding are kept and only laid out again with the new options
+        // The scoreDefs drawn in the layers have to be created again before the layout
+        m_doc.ResetDrawingPage();
+        m_doc.CollectScoreDefs(true);
+        int i;
+        for (i = 0; i < m_doc.GetChildCount(); i++) {
+            Page *page = dynamic_cast<Page *>(m_doc.GetChild(i));
+            if (page) page->ResetLayout();
+        }
+    }
+    else if (m_noLayout) {
+        // Back to one single page with one single system, laid out when rendered
+        m_doc.UnCastOffDoc();
+        m_layoutFromEncoding = false;
+    }
+    else if ((stage == OPTIONS_VERTICAL) && !m_doc.HasPendingPage()) {
+        // The systems are kept and only the pages are cast off again
+        m_doc.CastOffPagesDoc();
+    }
+    else {
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, false);
+        m_doc.UnCastOffDoc();
+        if (m_incrementalLayout)
+            m_doc.CastOffDocIncrementally();
+        else
+            m_doc.CastOffDoc();
+        m_layoutFromEncoding = false;
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, true);
+    }
+
+    m_layoutFont = m_doc.GetMusicFont();
+    m_layoutIncremental = m_incrementalLayout;
+
+    this->ClearSvgCache();
+}
 
-    m_doc.UnCastOffDoc();
-    m_doc.CastOffDoc();
+const std::string *Toolkit::GetCachedSvg(const SvgCacheKey &key)
+{
+    auto iter = m_svgCacheIndex.find(key);
+    if (iter == m_svgCacheIndex.end()) return NULL;
+    // Move the page to the front since it is now the most recently used
+    m_svgCache.splice(m_svgCache.begin(), m_svgCache, iter->second);
+    return &iter->second->second;
+}
+
+void Toolkit::AddCachedSvg(const SvgCacheKey &key, const std::string &svg)
+{
+    size_t maxBytes = (size_t)m_svgCacheSize * 1024 * 1024;
+    // Pages larger than the cache are not added
+    if (svg.size() > maxBytes) return;
+
+    while (!m_svgCache.empty() && (m_svgCacheBytes + svg.size() > maxBytes)) {
+        m_svgCacheBytes -= m_svgCache.back().second.size();
+        m_svgCacheIndex.erase(m_svgCache.back().first);
+        m_svgCache.pop_back();
+    }
+    m_svgCache.push_front(std::make_pair(key, svg));
+    m_svgCacheIndex[key] = m_svgCache.begin();
+    m_svgCacheBytes += svg.size();
+}
+
+void Toolkit::ClearSvgCache()
+{
+    m_svgCache.clear();
+    m_svgCacheIndex.clear();
+    m_svgCacheBytes = 0;
 }
 
 void Toolkit::RedoPagePitchPosLayout()
@@ -803,6 +1134,8 @@ void Toolkit::RedoPagePitchPosLayout()
         return;
     }
 
+    this->ClearSvgCache();
+
     page->LayOutPitchPos();
 }
 
@@ -811,8 +1144,31 @@ std::string Toolkit::RenderToSvg(int pageNo, bool xml_declaration)
     // Page number is one-based - correct it to 0-based first
     pageNo--;
 
+    // Apply the options changed since the last layout
+    this->UpdateLayout(this->GetInvalidatedStage(), true);
+
+    // Make sure the page has been cast off when doing it incrementally
+    if (m_doc.HasPendingPage()) {
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, false);
+        m_doc.CastOffPendingPages(pageNo);
+        this->CallStageHook(TOOLKIT_STAGE_CASTOFF, -1, true);
+    }
+    if (!m_doc.HasPage(pageNo)) {
+        LogError("Page %d does not exist", pageNo + 1);
+        return "";
+    }
+
     // Get the current system for the SVG clipping size
+    this->CallStageHook(TOOLKIT_STAGE_LAYOUT, pageNo, false);
     m_view.SetPage(pageNo);
+    this->CallStageHook(TOOLKIT_STAGE_LAYOUT, pageNo, true);
+
+    // The page is still set as the drawing page, e.g., for looking for elements on it after a cached render
+    SvgCacheKey cacheKey(pageNo, m_scale, m_showBoundingBoxes, xml_declaration, m_adjustPageHeight);
+    if (m_svgCacheSize > 0) {
+        const std::string *cachedSvg = this->GetCachedSvg(cacheKey);
+        if (cachedSvg) return *cachedSvg;
+    }
 
     // Adjusting page width and height according to the options
     int width = m_pageWidth;
@@ -835,6 +1191,7 @@ std::string Toolkit::RenderToSvg(int pageNo, bool xml_declaration)
     m_view.DrawCurrentPage(&svg, false);
 
     std::string out_str = svg.GetStringSVG(xml_declaration);
+    if (m_svgCacheSize > 0) this->AddCachedSvg(cacheKey, out_str);
     return out_str;
 }
 
@@ -881,18 +1238,41 @@ void Toolkit::GetHumdrum(ostream &output)
 }
 
 std::string Toolkit::RenderToMidi()
+{
+    std::string buffer;
+    StringOutputBuffer outputBuffer(&buffer);
+    std::ostream output(&outputBuffer);
+    this->RenderToMidi(output);
+
+    return Base64Encode(reinterpret_cast<const unsigned char *>(buffer.data()), (unsigned int)buffer.size());
+}
+
+bool Toolkit::RenderToMidi(std::ostream &output)
 {
     MidiFile outputfile;
-    outputfile.absoluteTicks();
-    m_doc.ExportMIDI(&outputfile);
-    outputfile.sortTracks();
+    this->GenerateMidiFile(&outputfile);
+
+    return (outputfile.write(output) != 0);
+}
 
-    stringstream strstrem;
-    outputfile.write(strstrem);
-    std::string outputstr = Base64Encode(
-        reinterpret_cast<const unsigned char *>(strstrem.str().c_str()), (unsigned int)strstrem.str().length());
+int Toolkit::RenderToMidiBuffer()
+{
+    m_binaryBuffer.clear();
+    StringOutputBuffer outputBuffer(&m_binaryBuffer);
+    std::ostream output(&outputBuffer);
+    this->RenderToMidi(output);
 
-    return outputstr;
+    return (int)m_binaryBuffer.size();
+}
+
+void Toolkit::GenerateMidiFile(MidiFile *midiFile)
+{
+    assert(midiFile);
+
+    midiFile->absoluteTicks();
+    m_doc.ExportMIDI(midiFile);
+    // The tracks of the staves are already sorted by the export
+    midiFile->sortTrack((*midiFile)[0]);
 }
 
 std::string Toolkit::GetElementsAtTime(int millisec)
@@ -901,16 +1281,17 @@ std::string Toolkit::GetElementsAtTime(int millisec)
     jsonxx::Object o;
     jsonxx::Array a;
 
-    double time = (double)(millisec * 120 / 1000);
-    NoteOnsetOffsetComparison matchTime(time);
     ArrayOfObjects notes;
     // Here we would need to check that the midi export is done
     if (m_doc.GetMidiExportDone()) {
+        // The real time is converted to the score time of the notes with the timemap built by the midi export
+        NoteOnsetOffsetComparison matchTime(m_doc.GetTimemap()->GetScoreTimeForRealTime(millisec));
         m_doc.FindAllChildByAttComparison(&notes, &matchTime);
 
         // Get the pageNo from the first note (if any)
         int pageNo = -1;
         if (notes.size() > 0) {
+            m_doc.CastOffPendingPagesTo(notes.at(0));
             Page *page = dynamic_cast<Page *>(notes.at(0)->GetFirstParent(PAGE));
             if (page) pageNo = page->GetIdx() + 1;
         }
@@ -933,9 +1314,7 @@ std::string Toolkit::GetElementsAtTime(int millisec)
 bool Toolkit::RenderToMidiFile(const std::string &filename)
 {
     MidiFile outputfile;
-    outputfile.absoluteTicks();
-    m_doc.ExportMIDI(&outputfile);
-    outputfile.sortTracks();
+    this->GenerateMidiFile(&outputfile);
     outputfile.write(filename);
 
     return true;
@@ -943,15 +1322,18 @@ bool Toolkit::RenderToMidiFile(const std::string &filename)
 
 int Toolkit::GetPageCount()
 {
-    return m_doc.GetPageCount();
+    this->UpdateLayout(this->GetInvalidatedStage(), true);
+    return m_doc.GetEstimatedPageCount();
 }
 
 int Toolkit::GetPageWithElement(const std::string &xmlId)
 {
+    this->UpdateLayout(this->GetInvalidatedStage(), true);
     Object *element = m_doc.FindChildByUuid(xmlId);
     if (!element) {
         return 0;
     }
+    m_doc.CastOffPendingPagesTo(element);
     Page *page = dynamic_cast<Page *>(element->GetFirstParent(PAGE));
     if (!page) {
         return 0;
@@ -963,97 +1345,65 @@ double Toolkit::GetTimeForElement(const std::string &xmlId)
 {
     Object *element = m_doc.FindChildByUuid(xmlId);
     double timeofElement = 0.0;
-    if (element->Is(NOTE)) {
+    if (element && element->Is(NOTE) && m_doc.GetMidiExportDone()) {
         Note *note = dynamic_cast<Note *>(element);
         assert(note);
-        timeofElement = note->m_playingOnset * 1000 / 120;
+        timeofElement = m_doc.GetTimemap()->GetRealTimeForScoreTime(note->m_playingOnset);
     }
     return timeofElement;
 }
 
 void Toolkit::SetCString(const std::string &data)
 {
-    if (m_cString) {
-        free(m_cString);
-        m_cString = NULL;
-    }
+    // The storage of the previous string is reused when it is large enough
+    m_cString.assign(data);
+}
 
-    m_cString = (char *)malloc(strlen(data.c_str()) + 1);
+void Toolkit::SetCString(std::string &&data)
+{
+    m_cString = std::move(data);
+}
 
-    // something went wrong
-    if (!m_cString) {
-        return;
-    }
-    strcpy(m_cString, data.c_str());
+void Toolkit::ReleaseCString()
+{
+    std::string().swap(m_cString);
 }
 
 void Toolkit::SetHumdrumBuffer(const char *data)
 {
-    if (m_humdrumBuffer) {
-        free(m_humdrumBuffer);
-        m_humdrumBuffer = NULL;
-    }
-
 #ifndef NO_HUMDRUM_SUPPORT
     hum::HumdrumFile file;
     file.readString(data);
     // apply Humdrum tools if there are any filters in the file.
     if (file.hasFilters()) {
-        string output;
         hum::Tool_filter filter;
         filter.run(file);
         if (filter.hasHumdrumText()) {
-            output = filter.getHumdrumText();
+            m_humdrumBuffer = filter.getHumdrumText();
         }
         else {
             // humdrum structure not always correct in output from tools
             // yet, so reload.
             stringstream tempdata;
             tempdata << file;
-            output = tempdata.str();
+            m_humdrumBuffer = tempdata.str();
         }
-        m_humdrumBuffer = (char *)malloc(output.size() + 1);
-        if (!m_humdrumBuffer) {
-            // something went wrong
-            return;
-        }
-        strcpy(m_humdrumBuffer, output.c_str());
-    }
-    else {
-        int size = (int)strlen(data) + 1;
-        m_humdrumBuffer = (char *)malloc(size);
-        if (!m_humdrumBuffer) {
-            // something went wrong
-            return;
-        }
-        strcpy(m_humdrumBuffer, data);
-    }
-
-#else
-    size_t size = (int)strlen(data) + 1;
-    m_humdrumBuffer = (char *)malloc(size);
-    if (!m_humdrumBuffer) {
-        // something went wrong
         return;
     }
-    strcpy(m_humdrumBuffer, data);
 #endif
+
+    m_humdrumBuffer = data;
 }
 
 const char *Toolkit::GetCString()
 {
-    if (m_cString) {
-        return m_cString;
-    }
-    else {
-        return "[unspecified]";
-    }
+    return m_cString.c_str();
 }
 
 const char *Toolkit::GetHumdrumBuffer()
 {
-    if (m_humdrumBuffer) {
-        return m_humdrumBuffer;
+    if (!m_humdrumBuffer.empty()) {
+        return m_humdrumBuffer.c_str();
     }
     else {
         return "[empty]";
@@ -1081,6 +1431,9 @@ bool Toolkit::Drag(std::string elementId, int x, int y)
             = (data_PITCHNAME)m_view.CalculatePitchCode(layer, m_view.ToLogicalY(y), note->GetDrawingX(), &oct);
         note->SetPname(pname);
         note->SetOct(oct);
+        // The MIDI data of the measure will be generated again
+        note->Modify();
+        this->ClearSvgCache();
         return true;
     }
     return false;
@@ -1115,6 +1468,7 @@ bool Toolkit::Insert(std::string elementType, std::string startid, std::string e
         slur->SetEndid(endid);
         measure->AddChild(slur);
         m_doc.PrepareDrawing();
+        this->ClearSvgCache();
         return true;
     }
     return false;
@@ -1124,16 +1478,204 @@ bool Toolkit::Set(std::string elementId, std::string attrType, std::string attrV
 {
     if (!m_doc.GetDrawingPage()) return false;
     Object *element = m_doc.GetDrawingPage()->FindChildByUuid(elementId);
-    if (Att::SetCmn(element, attrType, attrValue)) return true;
-    if (Att::SetCmnornaments(element, attrType, attrValue)) return true;
-    if (Att::SetCritapp(element, attrType, attrValue)) return true;
-    if (Att::SetExternalsymbols(element, attrType, attrValue)) return true;
-    if (Att::SetMei(element, attrType, attrValue)) return true;
-    if (Att::SetMensural(element, attrType, attrValue)) return true;
-    if (Att::SetMidi(element, attrType, attrValue)) return true;
-    if (Att::SetPagebased(element, attrType, attrValue)) return true;
-    if (Att::SetShared(element, attrType, attrValue)) return true;
+    if (!element) return false;
+    bool success = false;
+    if (Att::SetCmn(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetCmnornaments(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetCritapp(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetExternalsymbols(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetMei(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetMensural(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetMidi(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetPagebased(element, attrType, attrValue))
+        success = true;
+    else if (Att::SetShared(element, attrType, attrValue))
+        success = true;
+    // The MIDI data of the measure will be generated again
+    if (success) {
+        element->Modify();
+        this->ClearSvgCache();
+    }
+    return success;
+}
+
+bool Toolkit::SelectReadings(
+    const std::string &appSource, const std::vector<std::string> &choiceChildren, const std::vector<std::string> &ids)
+{
+    if (m_doc.GetChildCount() == 0) return false;
+
+    // The <app> and <choice> within hidden readings have to be found too
+    AttComparisonAny matchType({ APP, CHOICE });
+    ArrayOfObjects editorialElements;
+    Functor findAllByAttComparison(&Object::FindAllByAttComparison, "FindAllByAttComparison");
+    findAllByAttComparison.m_visibleOnly = false;
+    FindAllByAttComparisonParams findAllByAttComparisonParams(&matchType, &editorialElements);
+    m_doc.Process(&findAllByAttComparison, &findAllByAttComparisonParams);
+
+    std::string source = (appSource.compare(0, 1, "#") == 0) ? appSource.substr(1) : appSource;
+
+    std::vector<std::pair<EditorialElement *, EditorialElement *> > selections;
+    std::vector<Measure *> measures;
+    int i;
+    ArrayOfObjects::iterator iter;
+    for (iter = editorialElements.begin(); iter != editorialElements.end(); ++iter) {
+        EditorialElement *element = dynamic_cast<EditorialElement *>(*iter);
+        assert(element);
+        EditorialElement *selected = NULL;
+        for (i = 0; i < element->GetChildCount(); i++) {
+            EditorialElement *child = dynamic_cast<EditorialElement *>(element->GetChild(i));
+            if (!child) continue;
+            if (std::find(ids.begin(), ids.end(), child->GetUuid()) != ids.end()) {
+                selected = child;
+                break;
+            }
+        }
+        if (!selected && element->Is(APP) && !source.empty()) {
+            EditorialElement *lem = NULL;
+            for (i = 0; i < element->GetChildCount(); i++) {
+                EditorialElement *child = dynamic_cast<EditorialElement *>(element->GetChild(i));
+                AttSource *attSource = dynamic_cast<AttSource *>(child);
+                if (!child || !attSource) continue;
+                if (child->Is(LEM) && !lem) lem = child;
+                std::istringstream iss(attSource->GetSource());
+                std::string token;
+                while (iss >> token) {
+                    if (token.compare(0, 1, "#") == 0) token = token.substr(1);
+                    if (token == source) selected = child;
+                }
+                if (selected) break;
+            }
+            if (!selected) selected = lem ? lem : dynamic_cast<EditorialElement *>(element->GetFirst());
+        }
+        else if (!selected && element->Is(CHOICE) && !choiceChildren.empty()) {
+            for (i = 0; i < element->GetChildCount(); i++) {
+                EditorialElement *child = dynamic_cast<EditorialElement *>(element->GetChild(i));
+                if (!child) continue;
+                std::string name = child->GetClassName();
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                if (std::find(choiceChildren.begin(), choiceChildren.end(), name) != choiceChildren.end()) {
+                    selected = child;
+                    break;
+                }
+            }
+            if (!selected) selected = dynamic_cast<EditorialElement *>(element->GetFirst());
+        }
+        if (!selected) continue;
+
+        // The system-level ones have been converted to boundaries and can only be selected when loading
+        Measure *measure = dynamic_cast<Measure *>(element->GetFirstParent(MEASURE));
+        if (!measure) {
+            if (selected->m_visibility == Hidden) {
+                LogWarning("The selection of '%s' requires the data to be loaded again", selected->GetUuid().c_str());
+            }
+            continue;
+        }
+        // Nothing to do if the reading is already the visible one
+        bool changed = false;
+        for (i = 0; i < element->GetChildCount(); i++) {
+            EditorialElement *child = dynamic_cast<EditorialElement *>(element->GetChild(i));
+            if (child && ((child == selected) != (child->m_visibility == Visible))) changed = true;
+        }
+        if (!changed) continue;
+        selections.push_back(std::make_pair(element, selected));
+        if (std::find(measures.begin(), measures.end(), measure) == measures.end()) measures.push_back(measure);
+    }
+
+    if (selections.empty()) return true;
+
+    // Only the measures changed are prepared unless they are linked to other ones, which is looked up before the change
+    bool prepareMeasures = !m_doc.HasDrawingLinksAcross(measures);
+
+    Page *firstPage = NULL;
+    std::vector<std::pair<EditorialElement *, EditorialElement *> >::iterator selection;
+    for (selection = selections.begin(); selection != selections.end(); ++selection) {
+        selection->first->SetVisibleChild(selection->second);
+    }
+    std::vector<Measure *>::iterator measureIter;
+    for (measureIter = measures.begin(); measureIter != measures.end(); ++measureIter) {
+        // The MIDI data of the measure will be generated again and its page cast off again
+        (*measureIter)->Modify();
+        Page *page = dynamic_cast<Page *>((*measureIter)->GetFirstParent(PAGE));
+        if (page && (!firstPage || (page->GetIdx() < firstPage->GetIdx()))) firstPage = page;
+    }
+
+    // Each measure is prepared on its own unless something prepared across measures is left over
+    for (measureIter = measures.begin(); measureIter != measures.end(); ++measureIter) {
+        if (!prepareMeasures) break;
+        prepareMeasures = m_doc.PrepareDrawing(*measureIter, false);
+    }
+    // Preparing the entire document resets the drawing values of all the pages, which all have to be laid out again
+    if (!prepareMeasures) {
+        m_doc.PrepareDrawing();
+        firstPage = dynamic_cast<Page *>(m_doc.GetFirst(PAGE));
+    }
+
+    if (!firstPage) return true;
+
+    if (m_layoutFromEncoding || m_noLayout || (m_doc.GetType() == Transcription)) {
+        // The system breaks are kept, but the scoreDefs drawn in the layers are created again from the first page
+        // changed, and so the following pages have to be laid out again too
+        m_doc.CollectScoreDefsFromPage(firstPage->GetIdx());
+        for (i = firstPage->GetIdx(); i < m_doc.GetChildCount(); i++) {
+            Page *page = dynamic_cast<Page *>(m_doc.GetChild(i));
+            if (page) page->ResetLayout();
+        }
+        this->ClearSvgCache();
+    }
+    // The systems and the pages are cast off again from the first page changed, or entirely if it is not possible
+    else if (m_doc.CastOffDocFrom(firstPage, m_incrementalLayout)) {
+        this->ClearSvgCache();
+    }
+    else {
+        this->UpdateLayout(OPTIONS_CASTOFF);
+    }
+
+    return true;
+}
+
+bool Toolkit::SelectReadings(const std::string &json_selection)
+{
+#if defined(USE_EMSCRIPTEN) || defined(PYTHON_BINDING)
+
+    jsonxx::Object json;
+
+    // Read JSON selection
+    if (!json.parse(json_selection)) {
+        LogError("Can not parse JSON string.");
+        return false;
+    }
+
+    std::string appSource;
+    std::vector<std::string> choiceChildren;
+    std::vector<std::string> ids;
+    if (json.has<jsonxx::String>("appSource")) appSource = json.get<jsonxx::String>("appSource");
+    int i;
+    if (json.has<jsonxx::Array>("choiceChildren")) {
+        jsonxx::Array values = json.get<jsonxx::Array>("choiceChildren");
+        for (i = 0; i < values.size(); i++) {
+            if (values.has<jsonxx::String>(i)) choiceChildren.push_back(values.get<jsonxx::String>(i));
+        }
+    }
+    if (json.has<jsonxx::Array>("ids")) {
+        jsonxx::Array values = json.get<jsonxx::Array>("ids");
+        for (i = 0; i < values.size(); i++) {
+            if (values.has<jsonxx::String>(i)) ids.push_back(values.get<jsonxx::String>(i));
+        }
+    }
+
+    return this->SelectReadings(appSource, choiceChildren, ids);
+
+#else
+    // The non-js version of the app should not use this function.
     return false;
+#endif
 }
 
 #ifdef USE_EMSCRIPTEN
@@ -9,6 +9,7 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
 #include <math.h>
 
@@ -87,6 +88,74 @@ StaffAlignment *SystemAligner::GetStaffAlignmentForStaffN(int staffN) const
     return NULL;
 }
 
+//----------------------------------------------------------------------------
+// OverflowBBoxes
+//----------------------------------------------------------------------------
+
+void OverflowBBoxes::Clear()
+{
+    m_boxes.clear();
+    m_index.clear();
+}
+
+void OverflowBBoxes::Add(BoundingBox *box)
+{
+    assert(box);
+
+    m_boxes.push_back(box);
+
+    // Boxes without content bounding box never overlap and do not need to be indexed
+    if (!box->HasContentBB()) return;
+
+    int left = box->GetContentLeft();
+    int right = box->GetContentRight();
+    m_index[GetWidthClass(right - left)].insert(
+        std::make_pair(left, std::make_pair(right, (int)m_boxes.size() - 1)));
+}
+
+void OverflowBBoxes::FindHorizontalContentOverlaps(const BoundingBox *box, ArrayOfBoundingBoxes &overlaps) const
+{
+    assert(box);
+
+    overlaps.clear();
+
+    if (!box->HasContentBB()) return;
+
+    int left = box->GetContentLeft();
+    int right = box->GetContentRight();
+
+    std::vector<int> indexes;
+    std::map<int, std::multimap<int, std::pair<int, int> > >::const_iterator widthClass;
+    for (widthClass = m_index.begin(); widthClass != m_index.end(); ++widthClass) {
+        // All the boxes of the class are narrower than maxWidth, so the ones starting at left - maxWidth or before
+        // end before left. We only need to look at the ones starting between there and right.
+        int maxWidth = (1 << widthClass->first);
+        std::multimap<int, std::pair<int, int> >::const_iterator iter
+            = widthClass->second.upper_bound(left - maxWidth);
+        std::multimap<int, std::pair<int, int> >::const_iterator end = widthClass->second.lower_bound(right);
+        for (; iter != end; ++iter) {
+            if (iter->second.first > left) indexes.push_back(iter->second.second);
+        }
+    }
+
+    // Return them in the order they were added since the callers can depend on it
+    std::sort(indexes.begin(), indexes.end());
+    std::vector<int>::iterator iter;
+    for (iter = indexes.begin(); iter != indexes.end(); ++iter) {
+        overlaps.push_back(m_boxes.at(*iter));
+    }
+}
+
+int OverflowBBoxes::GetWidthClass(int width)
+{
+    int widthClass = 0;
+    while (width > 0) {
+        width >>= 1;
+        widthClass++;
+    }
+    return widthClass;
+}
+
 //----------------------------------------------------------------------------
 // StaffAlignment
 //----------------------------------------------------------------------------
@@ -217,19 +286,22 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
 
     if (params->m_classId == SYL) {
         if (this->GetVerseCount() > 0) {
-            FontInfo *lyricFont = params->m_doc->GetDrawingLyricFont(m_staff->m_drawingStaffSize);
-            int descender = params->m_doc->GetTextGlyphDescender(L'q', lyricFont, false);
-            int height = params->m_doc->GetTextGlyphHeight(L'I', lyricFont, false);
+            // Use a local font because the document one cannot be changed while systems are laid out concurrently
+            FontInfo lyricFont;
+            lyricFont.SetPointSize(params->m_doc->GetDrawingLyricFontSize(m_staff->m_drawingStaffSize));
+            int descender = params->m_doc->GetTextGlyphDescender(L'q', &lyricFont, false);
+            int height = params->m_doc->GetTextGlyphHeight(L'I', &lyricFont, false);
             int margin
                 = params->m_doc->GetBottomMargin(SYL) * params->m_doc->GetDrawingUnit(staffSize) / PARAM_DENOMINATOR;
             this->SetOverflowBelow(this->m_overflowBelow + this->GetVerseCount() * (height - descender + margin));
             // For now just clear the overflowBelow, which avoids the overlap to be calculated. We could also keep them
             // and check if they are some lyrics in order to know if the overlap needs to be calculated or not.
-            m_overflowBelowBBoxes.clear();
+            m_overflowBelowBBoxes.Clear();
         }
         return FUNCTOR_SIBLINGS;
     }
 
+    ArrayOfBoundingBoxes overlaps;
     ArrayOfFloatingPositioners::iterator iter;
     for (iter = m_floatingPositioners.begin(); iter != m_floatingPositioners.end(); ++iter) {
         assert((*iter)->GetObject());
@@ -255,7 +327,7 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
             if (overflowAbove > params->m_doc->GetDrawingStaffLineWidth(staffSize) / 2) {
                 // LogMessage("%sparams->m_doctop overflow: %d", current->GetUuid().c_str(), overflowAbove);
                 this->SetOverflowAbove(overflowAbove);
-                this->m_overflowAboveBBoxes.push_back((*iter));
+                this->m_overflowAboveBBoxes.Add((*iter));
             }
 
             int overflowBelow = 0;
@@ -263,7 +335,7 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
             if (overflowBelow > params->m_doc->GetDrawingStaffLineWidth(staffSize) / 2) {
                 // LogMessage("%s bottom overflow: %d", current->GetUuid().c_str(), overflowBelow);
                 this->SetOverflowBelow(overflowBelow);
-                this->m_overflowBelowBBoxes.push_back((*iter));
+                this->m_overflowBelowBBoxes.Add((*iter));
             }
             continue;
         }
@@ -271,32 +343,28 @@ int StaffAlignment::AdjustFloatingPostioners(FunctorParams *functorParams)
         // This sets the default position (without considering any overflowing box)
         (*iter)->CalcDrawingYRel(params->m_doc, this, NULL);
 
-        ArrayOfBoundingBoxes *overflowBoxes = &m_overflowBelowBBoxes;
+        OverflowBBoxes *overflowBoxes = &m_overflowBelowBBoxes;
         // above?
         if ((*iter)->GetDrawingPlace() == STAFFREL_above) {
             overflowBoxes = &m_overflowAboveBBoxes;
         }
-        auto i = overflowBoxes->begin();
-        auto end = overflowBoxes->end();
-        while (i != end) {
-            // find all the overflowing elements from the staff that overlap horizonatally
-            i = std::find_if(i, end, [iter](BoundingBox *elem) { return (*iter)->HorizontalContentOverlap(elem); });
-            if (i != end) {
-                // update the yRel accordingly
-                (*iter)->CalcDrawingYRel(params->m_doc, this, *i);
-                i++;
-            }
+        // find all the overflowing elements from the staff that overlap horizonatally
+        overflowBoxes->FindHorizontalContentOverlaps(*iter, overlaps);
+        ArrayOfBoundingBoxes::iterator i;
+        for (i = overlaps.begin(); i != overlaps.end(); ++i) {
+            // update the yRel accordingly
+            (*iter)->CalcDrawingYRel(params->m_doc, this, *i);
         }
         //  Now update the staffAlignment max overflow (above or below) and add the positioner to the list of
         //  overflowing elements
         if ((*iter)->GetDrawingPlace() == STAFFREL_above) {
             int overflowAbove = this->CalcOverflowAbove((*iter));
-            overflowBoxes->push_back((*iter));
+            overflowBoxes->Add((*iter));
             this->SetOverflowAbove(overflowAbove);
         }
         else {
             int overflowBelow = this->CalcOverflowBelow((*iter));
-            overflowBoxes->push_back((*iter));
+            overflowBoxes->Add((*iter));
             this->SetOverflowBelow(overflowBelow);
         }
     }
@@ -371,25 +439,22 @@ int StaffAlignment::AdjustStaffOverlap(FunctorParams *functorParams)
         return FUNCTOR_SIBLINGS;
     }
 
-    ArrayOfBoundingBoxes::iterator iter;
+    ArrayOfBoundingBoxes overlaps;
+    const ArrayOfBoundingBoxes *previousBoxes = params->m_previous->m_overflowBelowBBoxes.GetBoxes();
+    ArrayOfBoundingBoxes::const_iterator iter;
     // go through all the elements of the top staff that have an overflow below
-    for (iter = params->m_previous->m_overflowBelowBBoxes.begin();
-         iter != params->m_previous->m_overflowBelowBBoxes.end(); iter++) {
-        auto i = m_overflowAboveBBoxes.begin();
-        auto end = m_overflowAboveBBoxes.end();
-        while (i != end) {
-            // find all the elements from the bottom staff that have an overflow at the top with an horizontal overap
-            i = std::find_if(i, end, [iter](BoundingBox *elem) { return (*iter)->HorizontalContentOverlap(elem); });
-            if (i != end) {
-                // calculate the vertical overlap and see if this is more than the expected space
-                int overflowBelow = params->m_previous->CalcOverflowBelow(*iter);
-                int overflowAbove = this->CalcOverflowAbove(*i);
-                int spacing = std::max(params->m_previous->m_overflowBelow, this->m_overflowAbove);
-                if (spacing < (overflowBelow + overflowAbove)) {
-                    // LogDebug("Overlap %d", (overflowBelow + overflowAbove) - spacing);
-                    this->SetOverlap((overflowBelow + overflowAbove) - spacing);
-                }
-                i++;
+    for (iter = previousBoxes->begin(); iter != previousBoxes->end(); iter++) {
+        // find all the elements from the bottom staff that have an overflow at the top with an horizontal overap
+        m_overflowAboveBBoxes.FindHorizontalContentOverlaps(*iter, overlaps);
+        ArrayOfBoundingBoxes::iterator i;
+        for (i = overlaps.begin(); i != overlaps.end(); ++i) {
+            // calculate the vertical overlap and see if this is more than the expected space
+            int overflowBelow = params->m_previous->CalcOverflowBelow(*iter);
+            int overflowAbove = this->CalcOverflowAbove(*i);
+            int spacing = std::max(params->m_previous->m_overflowBelow, this->m_overflowAbove);
+            if (spacing < (overflowBelow + overflowAbove)) {
+                // LogDebug("Overlap %d", (overflowBelow + overflowAbove) - spacing);
+                this->SetOverlap((overflowBelow + overflowAbove) - spacing);
             }
         }
     }
@@ -64,6 +64,13 @@ void View::DrawControlElement(DeviceContext *dc, ControlElement *element, Measur
     assert(measure);
     assert(element);
 
+    // The horizontal layout does not look at the control elements, which are all positioned by the vertical layout
+    if (dc->Is(BBOX_DEVICE_CONTEXT)) {
+        BBoxDeviceContext *bBoxDC = dynamic_cast<BBoxDeviceContext *>(dc);
+        assert(bBoxDC);
+        if (!bBoxDC->UpdateVerticalValues()) return;
+    }
+
     // For dir, dynam, fermata, and harm, we do not consider the @tstamp2 for rendering
     if (element->HasInterface(INTERFACE_TIME_SPANNING) && !element->Is(DIR) && !element->Is(DYNAM)
         && !element->Is(FERMATA) && !element->Is(HARM)) {
@@ -923,7 +930,7 @@ float View::AdjustSlur(Slur *slur, Staff *staff, int layerN, curvature_CURVEDIR
     filters.push_back(&matchStaff);
     filters.push_back(&matchLayer);
 
-    Functor timeSpanningLayerElements(&Object::FindTimeSpanningLayerElements);
+    Functor timeSpanningLayerElements(&Object::FindTimeSpanningLayerElements, "FindTimeSpanningLayerElements");
     system->Process(&timeSpanningLayerElements, &findTimeSpanningLayerElementsParams, NULL, &filters);
     // if (spanningContent.size() > 12) LogDebug("### %d %s", spanningContent.size(), slur->GetUuid().c_str());
 
@@ -523,11 +523,11 @@ void View::DrawChord(DeviceContext *dc, LayerElement *element, Layer *layer, Sta
     // For cross staff chords we need to re-calculate the stem because the staff position might have changed
     if (chord->HasCrossStaff()) {
         SetAlignmentPitchPosParams setAlignmentPitchPosParams(this->m_doc);
-        Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos);
+        Functor setAlignmentPitchPos(&Object::SetAlignmentPitchPos, "SetAlignmentPitchPos");
         chord->Process(&setAlignmentPitchPos, &setAlignmentPitchPosParams);
 
         CalcStemParams calcStemParams(this->m_doc);
-        Functor calcStem(&Object::CalcStem);
+        Functor calcStem(&Object::CalcStem, "CalcStem");
         chord->Process(&calcStem, &calcStemParams);
     }
 
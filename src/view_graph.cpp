@@ -14,6 +14,7 @@
 
 //----------------------------------------------------------------------------
 
+#include "bboxdevicecontext.h"
 #include "devicecontext.h"
 #include "doc.h"
 #include "style.h"
@@ -163,6 +164,14 @@ void View::DrawSmuflCode(DeviceContext *dc, int x, int y, wchar_t code, int staf
 
     if (code == 0) return;
 
+    // When calculating bounding boxes, use the glyph metrics directly without going through the font stack
+    if (dc->Is(BBOX_DEVICE_CONTEXT)) {
+        BBoxDeviceContext *bBoxDC = dynamic_cast<BBoxDeviceContext *>(dc);
+        assert(bBoxDC);
+        bBoxDC->DrawMusicGlyph(code, x, y, m_doc->GetDrawingSmuflFontSize(staffSize, dimin), setBBGlyph);
+        return;
+    }
+
     dc->SetBackground(AxBLUE);
     dc->SetBackgroundMode(AxTRANSPARENT);
 
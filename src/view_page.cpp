@@ -47,10 +47,13 @@ namespace vrv {
 
 void View::DrawCurrentPage(DeviceContext *dc, bool background)
 {
+    PROFILE_STAGE("View::DrawCurrentPage");
+
     assert(dc);
     assert(m_doc);
 
     m_currentPage = m_doc->SetDrawingPage(m_pageIdx);
+    dc->SetMusicFont(m_doc->GetMusicFont());
 
     int i;
 
@@ -79,6 +82,29 @@ void View::DrawCurrentPage(DeviceContext *dc, bool background)
     dc->EndPage();
 }
 
+void View::DrawCurrentPageSystem(DeviceContext *dc, System *system)
+{
+    assert(dc);
+    assert(m_doc);
+    assert(m_currentPage);
+    assert(system);
+    assert(system->GetParent() == m_currentPage);
+
+    // Same as in View::DrawCurrentPage but for the system only
+    dc->SetMusicFont(m_doc->GetMusicFont());
+    SetScoreDefDrawingWidth(dc, &m_currentPage->m_drawingScoreDef);
+    m_drawingScoreDef = m_currentPage->m_drawingScoreDef;
+
+    Point origin = dc->GetLogicalOrigin();
+    dc->SetLogicalOrigin(origin.x - m_doc->m_drawingPageLeftMar, origin.y - m_doc->m_drawingPageTopMar);
+
+    dc->StartPage();
+
+    DrawSystem(dc, system);
+
+    dc->EndPage();
+}
+
 double View::GetPPUFactor() const
 {
     if (!m_currentPage) return 1.0;
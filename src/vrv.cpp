@@ -10,6 +10,7 @@
 
 //----------------------------------------------------------------------------
 
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <sstream>
@@ -18,6 +19,12 @@
 #include <stdlib.h>
 #include <vector>
 
+#ifndef NO_THREAD_SUPPORT
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif
+
 #ifndef _WIN32
 #include <dirent.h>
 #else
@@ -34,6 +41,7 @@
 #define GIT_COMMIT "[undefined]"
 #endif
 
+#include "devicecontextbase.h"
 #include "glyph.h"
 #include "smufl.h"
 #include "vrvdef.h"
@@ -57,8 +65,55 @@ namespace vrv {
 //----------------------------------------------------------------------------
 
 std::string Resources::m_path = "/usr/local/share/verovio";
-std::map<wchar_t, Glyph> Resources::m_font;
-std::map<wchar_t, Glyph> Resources::m_textFont;
+std::map<std::string, MusicFont> Resources::m_musicFonts;
+MusicFont *Resources::m_defaultMusicFont = NULL;
+std::map<wchar_t, Glyph> Resources::m_textFont[TEXT_VARIANT_COUNT];
+std::vector<std::vector<Glyph *> > Resources::m_textGlyphTable[TEXT_VARIANT_COUNT];
+Glyph Resources::m_textWideGlyph[TEXT_VARIANT_COUNT];
+std::string Resources::m_textFontPath = "";
+
+#ifndef NO_THREAD_SUPPORT
+/** The resources can be loaded from several toolkits at the same time (recursive because InitFonts calls GetMusicFont) */
+std::recursive_mutex resourcesMutex;
+#define RESOURCES_LOCK std::lock_guard<std::recursive_mutex> lock(resourcesMutex);
+#else
+#define RESOURCES_LOCK
+#endif
+
+//----------------------------------------------------------------------------
+// MusicFont
+//----------------------------------------------------------------------------
+
+MusicFont::MusicFont()
+{
+}
+
+Glyph *MusicFont::GetGlyph(wchar_t smuflCode)
+{
+    // Lookups are not locked since the font is not modified once loaded
+    if ((smuflCode >= SMUFL_FIRST_CODE) && (smuflCode <= SMUFL_LAST_CODE)) {
+        return m_glyphTable[smuflCode - SMUFL_FIRST_CODE];
+    }
+    std::map<wchar_t, Glyph>::iterator iter = m_glyphs.find(smuflCode);
+    if (iter == m_glyphs.end()) return NULL;
+    return &iter->second;
+}
+
+//----------------------------------------------------------------------------
+// Path related methods
+//----------------------------------------------------------------------------
+
+std::string Resources::GetPath()
+{
+    RESOURCES_LOCK
+    return m_path;
+}
+
+void Resources::SetPath(std::string path)
+{
+    RESOURCES_LOCK
+    m_path = path;
+}
 
 //----------------------------------------------------------------------------
 // Font related methods
@@ -66,16 +121,20 @@ std::map<wchar_t, Glyph> Resources::m_textFont;
 
 bool Resources::InitFonts()
 {
-    // We will need to rethink this for adding the option to add custom fonts
-    // Font Bravura first since it is expected to have always all symbols
-    if (!LoadFont("Bravura")) LogError("Bravura font could not be loaded.");
+    RESOURCES_LOCK
+
     // The Leipzig as the default font
-    if (!LoadFont("Leipzig")) LogError("Leipzig font could not be loaded.");
+    MusicFont *musicFont = GetMusicFont("Leipzig");
+    if (!musicFont) {
+        LogError("Leipzig font could not be loaded.");
+        return false;
+    }
 
-    if (m_font.size() < SMUFL_COUNT) {
-        LogError("Expected %d default SMUFL glyphs but could load only %d.", SMUFL_COUNT, m_font.size());
+    if (musicFont->GetGlyphCount() < SMUFL_COUNT) {
+        LogError("Expected %d default SMUFL glyphs but could load only %d.", SMUFL_COUNT, musicFont->GetGlyphCount());
         return false;
     }
+    m_defaultMusicFont = musicFont;
 
     if (!InitTextFont()) {
         LogError("Text font could not be initialized.");
@@ -87,23 +146,99 @@ bool Resources::InitFonts()
 
 bool Resources::SetFont(std::string fontName)
 {
-    return LoadFont(fontName);
+    RESOURCES_LOCK
+
+    MusicFont *musicFont = GetMusicFont(fontName);
+    if (!musicFont) return false;
+    m_defaultMusicFont = musicFont;
+    return true;
 }
 
-Glyph *Resources::GetGlyph(wchar_t smuflCode)
+MusicFont *Resources::GetMusicFont(const std::string &fontName)
 {
-    if (!m_font.count(smuflCode)) return NULL;
-    return &m_font[smuflCode];
+    RESOURCES_LOCK
+
+    // A font is loaded again only when the path changes, the ones loaded before remain valid
+    std::string key = m_path + "/" + fontName;
+    std::map<std::string, MusicFont>::iterator iter = m_musicFonts.find(key);
+    if (iter != m_musicFonts.end()) return &iter->second;
+
+    MusicFont *musicFont = &m_musicFonts[key];
+    // We will need to rethink this for adding the option to add custom fonts
+    // Font Bravura first since it is expected to have always all symbols
+    if ((fontName != "Bravura") && !LoadFont(musicFont, "Bravura")) {
+        LogError("Bravura font could not be loaded.");
+    }
+    // Then the default font, which gives the glyphs missing in the other fonts
+    if ((fontName != "Bravura") && (fontName != "Leipzig") && !LoadFont(musicFont, "Leipzig")) {
+        LogError("Leipzig font could not be loaded.");
+    }
+    if (!LoadFont(musicFont, fontName)) {
+        m_musicFonts.erase(key);
+        return NULL;
+    }
+
+    // The map is not modified anymore so the pointers remain valid
+    musicFont->m_name = fontName;
+    musicFont->m_glyphTable.assign(SMUFL_LAST_CODE - SMUFL_FIRST_CODE + 1, NULL);
+    std::map<wchar_t, Glyph>::iterator glyphIter;
+    for (glyphIter = musicFont->m_glyphs.begin(); glyphIter != musicFont->m_glyphs.end(); ++glyphIter) {
+        if ((glyphIter->first < SMUFL_FIRST_CODE) || (glyphIter->first > SMUFL_LAST_CODE)) continue;
+        musicFont->m_glyphTable[glyphIter->first - SMUFL_FIRST_CODE] = &glyphIter->second;
+    }
+
+    return musicFont;
 }
 
-Glyph *Resources::GetTextGlyph(wchar_t code)
+MusicFont *Resources::GetDefaultMusicFont()
 {
-    if (!m_textFont.count(code)) return NULL;
-    return &m_textFont[code];
+    RESOURCES_LOCK
+    return m_defaultMusicFont;
 }
 
-bool Resources::LoadFont(std::string fontName)
+Glyph *Resources::GetTextGlyph(wchar_t code, TextFontVariant variant)
 {
+    // Lookups are not locked and do not modify the tables
+    if ((code >= 0) && (code <= 0xFFFF)) {
+        const std::vector<std::vector<Glyph *> > &table = m_textGlyphTable[variant];
+        if (table.empty()) return NULL;
+        const std::vector<Glyph *> &block = table[code >> 8];
+        if (!block.empty() && block[code & 0xFF]) return block[code & 0xFF];
+    }
+    else {
+        std::map<wchar_t, Glyph>::iterator iter = m_textFont[variant].find(code);
+        if (iter != m_textFont[variant].end()) return &iter->second;
+    }
+    if (IsWideChar(code) && (m_textWideGlyph[variant].GetHorizAdvX() > 0)) return &m_textWideGlyph[variant];
+    return NULL;
+}
+
+TextFontVariant Resources::GetTextFontVariant(FontInfo *font)
+{
+    if (!font) return TEXT_REGULAR;
+    bool italic = ((font->GetStyle() == FONTSTYLE_italic) || (font->GetStyle() == FONTSTYLE_oblique));
+    bool bold = (font->GetWeight() == FONTWEIGHT_bold);
+    if (bold && italic) return TEXT_BOLD_ITALIC;
+    if (bold) return TEXT_BOLD;
+    if (italic) return TEXT_ITALIC;
+    return TEXT_REGULAR;
+}
+
+bool Resources::IsWideChar(wchar_t code)
+{
+    // The East Asian wide ranges (Hangul Jamo, CJK, Hangul syllables, compatibility and full-width forms)
+    return (((code >= 0x1100) && (code <= 0x115F)) || ((code >= 0x2E80) && (code <= 0xA4CF))
+        || ((code >= 0xAC00) && (code <= 0xD7A3)) || ((code >= 0xF900) && (code <= 0xFAFF))
+        || ((code >= 0xFE30) && (code <= 0xFE4F)) || ((code >= 0xFF00) && (code <= 0xFF60))
+        || ((code >= 0xFFE0) && (code <= 0xFFE6)));
+}
+
+bool Resources::LoadFont(MusicFont *musicFont, std::string fontName)
+{
+    RESOURCES_LOCK
+
+    assert(musicFont);
+
     ::DIR *dir;
     dirent *pdir;
     std::string dirname = Resources::GetPath() + "/" + fontName;
@@ -116,7 +251,7 @@ bool Resources::LoadFont(std::string fontName)
 
     // First loop through the fontName directory and load each glyph
     // Since the filename starts with the Unicode code, it is used
-    // to assign the glyph to the corresponding position in m_fonts
+    // to assign the glyph to the corresponding position in the font
     while ((pdir = readdir(dir))) {
         if (strstr(pdir->d_name, ".xml")) {
             // E.g, : E053-gClef8va.xml => strtol extracts E053 as hex
@@ -128,7 +263,7 @@ bool Resources::LoadFont(std::string fontName)
             std::string codeStr = pdir->d_name;
             codeStr = codeStr.substr(0, 4);
             Glyph glyph(Resources::GetPath() + "/" + fontName + "/" + pdir->d_name, codeStr);
-            m_font[smuflCode] = glyph;
+            musicFont->m_glyphs[smuflCode] = glyph;
         }
     }
 
@@ -154,11 +289,11 @@ bool Resources::LoadFont(std::string fontName)
         Glyph *glyph = NULL;
         if (current.attribute("c")) {
             wchar_t smuflCode = (wchar_t)strtol(current.attribute("c").value(), NULL, 16);
-            if (!m_font.count(smuflCode)) {
+            if (!musicFont->m_glyphs.count(smuflCode)) {
                 LogWarning("Glyph with code '%d' not found.", smuflCode);
                 continue;
             }
-            glyph = &m_font[smuflCode];
+            glyph = &musicFont->m_glyphs[smuflCode];
             if (glyph->GetUnitsPerEm() != unitsPerEm * 10) {
                 LogWarning("Glyph and bounding box units-per-em for code '%d' miss-match (bounding box: %d)", smuflCode,
                     unitsPerEm);
@@ -192,11 +327,35 @@ bool Resources::LoadFont(std::string fontName)
 
 bool Resources::InitTextFont()
 {
-    // For the text font, we load the bounding boxes only
-    pugi::xml_document doc;
+    RESOURCES_LOCK
+
+    // The text font is loaded again only when the path changes
+    if (!m_textFont[TEXT_REGULAR].empty() && (m_textFontPath == m_path)) return true;
+
     // For now, we have only Times bounding boxes for ASCII chars
     // For any other char, we currently use 'o' bounding box
-    std::string filename = Resources::GetPath() + "/text/Times.xml";
+    if (!LoadTextFont("Times", TEXT_REGULAR)) return false;
+
+    // A variant that cannot be loaded uses the regular bounding boxes
+    if (!LoadTextFont("Times-italic", TEXT_ITALIC)) LoadTextFont("Times", TEXT_ITALIC);
+    if (!LoadTextFont("Times-bold", TEXT_BOLD)) LoadTextFont("Times", TEXT_BOLD);
+    if (!LoadTextFont("Times-bold-italic", TEXT_BOLD_ITALIC)) LoadTextFont("Times", TEXT_BOLD_ITALIC);
+    m_textFontPath = m_path;
+
+    return true;
+}
+
+bool Resources::LoadTextFont(std::string fileName, TextFontVariant variant)
+{
+    RESOURCES_LOCK
+
+    m_textFont[variant].clear();
+    m_textGlyphTable[variant].clear();
+    m_textWideGlyph[variant] = Glyph();
+
+    // For the text font, we load the bounding boxes only
+    pugi::xml_document doc;
+    std::string filename = Resources::GetPath() + "/text/" + fileName + ".xml";
     pugi::xml_parse_result result = doc.load_file(filename.c_str());
     if (!result) {
         // File not found, default bounding boxes will be used
@@ -224,9 +383,29 @@ bool Resources::InitTextFont()
             if (current.attribute("h")) height = atof(current.attribute("h").value());
             glyph.SetBoundingBox(x, y, width, height);
             if (current.attribute("h-a-x")) glyph.SetHorizAdvX(atof(current.attribute("h-a-x").value()));
-            m_textFont[code] = glyph;
+            m_textFont[variant][code] = glyph;
         }
     }
+    // The lookup table for the BMP - the map is not modified anymore so the pointers remain valid
+    m_textGlyphTable[variant].resize(256);
+    std::map<wchar_t, Glyph>::iterator iter;
+    for (iter = m_textFont[variant].begin(); iter != m_textFont[variant].end(); ++iter) {
+        if ((iter->first < 0) || (iter->first > 0xFFFF)) continue;
+        std::vector<Glyph *> &block = m_textGlyphTable[variant][iter->first >> 8];
+        if (block.empty()) block.resize(256, NULL);
+        block[iter->first & 0xFF] = &iter->second;
+    }
+
+    // The wide characters missing in the font are one em wide with the height of an 'M'
+    Glyph *capital = GetTextGlyph(L'M', variant);
+    if (capital) {
+        int x, y, w, h;
+        capital->GetBoundingBox(x, y, w, h);
+        m_textWideGlyph[variant] = Glyph(unitsPerEm);
+        m_textWideGlyph[variant].SetBoundingBox(0.0, (double)y / 10.0, unitsPerEm, (double)h / 10.0);
+        m_textWideGlyph[variant].SetHorizAdvX(unitsPerEm);
+    }
+
     return true;
 }
 
@@ -241,6 +420,10 @@ bool noLog = false;
 
 #ifdef EMSCRIPTEN
 std::vector<std::string> logBuffer;
+#ifndef NO_THREAD_SUPPORT
+/** The log buffer can be appended from the threads started by ProcessConcurrently */
+std::mutex logBufferMutex;
+#endif
 #endif
 
 void LogElapsedTimeStart()
@@ -358,6 +541,9 @@ bool LogBufferContains(std::string s)
 
 void AppendLogBuffer(bool checkDuplicate, std::string message, consoleLogLevel level)
 {
+#ifndef NO_THREAD_SUPPORT
+    std::lock_guard<std::mutex> lock(logBufferMutex);
+#endif
     if (checkDuplicate && LogBufferContains(message)) return;
     logBuffer.push_back(message);
 
@@ -371,6 +557,31 @@ void AppendLogBuffer(bool checkDuplicate, std::string message, consoleLogLevel l
 
 #endif
 
+void ProcessConcurrently(int size, const std::function<void(int)> &func)
+{
+#ifndef NO_THREAD_SUPPORT
+    int threadCount = std::min((int)std::thread::hardware_concurrency(), size);
+#ifdef USE_EMSCRIPTEN
+    // The pool is fixed and can have fewer threads than the cores of the client
+    threadCount = std::min(threadCount, VRV_PTHREAD_POOL_SIZE);
+#endif
+    if (threadCount > 1) {
+        // Each thread picks the next index until all of them have been processed
+        std::atomic<int> next(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.push_back(std::thread([&next, size, &func]() {
+                int idx;
+                while ((idx = next++) < size) func(idx);
+            }));
+        }
+        for (std::thread &thread : threads) thread.join();
+        return;
+    }
+#endif
+    for (int i = 0; i < size; i++) func(i);
+}
+
 bool Check(Object *object)
 {
     assert(object);
@@ -451,6 +662,17 @@ std::string GetVersion()
     return StringFormat("%d.%d.%d%s-%s", VERSION_MAJOR, VERSION_MINOR, VERSION_REVISION, dev.c_str(), GIT_COMMIT);
 }
 
+unsigned long long HashData(const std::string &data, unsigned long long hash)
+{
+    const unsigned char *bytes = (const unsigned char *)data.data();
+    const unsigned char *end = bytes + data.size();
+    for (; bytes != end; bytes++) {
+        hash ^= (*bytes);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 //----------------------------------------------------------------------------
 // Base64 code borrowed
 //----------------------------------------------------------------------------
@@ -489,6 +711,7 @@ static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 std::string Base64Encode(unsigned char const *bytes_to_encode, unsigned int in_len)
 {
     std::string ret;
+    ret.reserve(4 * ((in_len + 2) / 3));
     int i = 0;
     int j = 0;
     unsigned char char_array_3[3];
@@ -523,4 +746,20 @@ std::string Base64Encode(unsigned char const *bytes_to_encode, unsigned int in_l
     return ret;
 }
 
+//----------------------------------------------------------------------------
+// StringOutputBuffer
+//----------------------------------------------------------------------------
+
+StringOutputBuffer::int_type StringOutputBuffer::overflow(int_type c)
+{
+    if (c != traits_type::eof()) m_output->push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+}
+
+std::streamsize StringOutputBuffer::xsputn(const char *s, std::streamsize n)
+{
+    m_output->append(s, (size_t)n);
+    return n;
+}
+
 } // namespace vrv
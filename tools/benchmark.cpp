@@ -0,0 +1,521 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        benchmark.cpp
+// Author:      Verovio contributors
+// Created:     2026
+// Copyright (c) Authors and others. All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#else
+#include "win_dirent.h"
+#include "win_getopt.h"
+#endif
+
+//----------------------------------------------------------------------------
+
+#include "object.h"
+#include "profiler.h"
+#include "toolkit.h"
+#include "vrv.h"
+
+//----------------------------------------------------------------------------
+
+#include "jsonxx.h"
+
+using namespace std;
+using namespace vrv;
+
+//----------------------------------------------------------------------------
+// Allocation counting
+//----------------------------------------------------------------------------
+
+// All the allocations going through the global operator new are counted, including the ones made by the layout
+// threads. The objects created with memory from the free lists of Object do not reach it and are counted with
+// Object::GetReusedAllocations, only when compiled with the ALLOCATION_COUNTING option.
+std::atomic<unsigned long long> allocationCount(0);
+std::atomic<unsigned long long> allocationBytes(0);
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    allocationBytes += size;
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+//----------------------------------------------------------------------------
+// Stages
+//----------------------------------------------------------------------------
+
+/**
+ * The stages measured, the first ones being a call to the toolkit.
+ * The load includes the parsing, the preparation and the cast off, and the render is the sum of the pages, which are
+ * laid out when rendered the first time. These are measured with the stage hook of the toolkit, from STAGE_PARSE in
+ * the order of ToolkitStage, and the layout is the sum of the pages. They are detailed further in the profile when
+ * the profiling is compiled in.
+ */
+enum {
+    STAGE_LOAD = 0,
+    STAGE_RENDER,
+    STAGE_MIDI,
+    STAGE_MEI,
+    STAGE_PARSE,
+    STAGE_PREPARE_DRAWING,
+    STAGE_CASTOFF,
+    STAGE_LAYOUT,
+    STAGE_COUNT
+};
+
+const char *stageNames[STAGE_COUNT]
+    = { "load", "render", "midi", "mei", "parse", "prepareDrawing", "castOff", "layout" };
+
+/**
+ * The time (in milliseconds) and the allocations of a stage.
+ * When a stage is run several times, the minimum time is kept but the allocations are the ones of the first run.
+ */
+class StageResult {
+public:
+    StageResult() : m_time(0.0), m_allocations(0), m_allocatedBytes(0) {}
+
+    void Add(const StageResult &result)
+    {
+        m_time += result.m_time;
+        m_allocations += result.m_allocations;
+        m_allocatedBytes += result.m_allocatedBytes;
+    }
+
+    void KeepMinTime(const StageResult &result) { m_time = std::min(m_time, result.m_time); }
+
+    double m_time;
+    unsigned long long m_allocations;
+    unsigned long long m_allocatedBytes;
+};
+
+/**
+ * Measure the time and the allocations between Start and Stop.
+ */
+class StageTimer {
+public:
+    void Start()
+    {
+        m_allocations = allocationCount + Object::GetReusedAllocations();
+        m_allocatedBytes = allocationBytes + Object::GetReusedBytes();
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    StageResult Stop()
+    {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        StageResult result;
+        result.m_time = std::chrono::duration<double, std::milli>(end - m_start).count();
+        result.m_allocations = allocationCount + Object::GetReusedAllocations() - m_allocations;
+        result.m_allocatedBytes = allocationBytes + Object::GetReusedBytes() - m_allocatedBytes;
+        return result;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    unsigned long long m_allocations;
+    unsigned long long m_allocatedBytes;
+};
+
+/**
+ * The results of all the stages for one file.
+ */
+class FileResult {
+public:
+    FileResult() : m_pageCount(0) {}
+
+    void KeepMinTime(const FileResult &result)
+    {
+        int i;
+        for (i = 0; i < STAGE_COUNT; i++) m_stages[i].KeepMinTime(result.m_stages[i]);
+        for (i = 0; i < (int)m_pageRenders.size() && i < (int)result.m_pageRenders.size(); i++) {
+            m_pageRenders.at(i).KeepMinTime(result.m_pageRenders.at(i));
+        }
+    }
+
+    std::string m_format;
+    int m_pageCount;
+    StageResult m_stages[STAGE_COUNT];
+    std::vector<StageResult> m_pageRenders;
+    /** The summary of the Profiler (JSON) for the first run */
+    std::string m_profile;
+};
+
+//----------------------------------------------------------------------------
+// Running the stages
+//----------------------------------------------------------------------------
+
+std::string formatName(FileFormat format)
+{
+    switch (format) {
+        case MEI: return "mei";
+        case HUMDRUM: return "humdrum";
+        case PAE: return "pae";
+        case DARMS: return "darms";
+        case MUSICXML: return "musicxml";
+        case MUSICXMLHUM: return "musicxml-hum";
+        default: return "unknown";
+    }
+}
+
+/**
+ * Run all the stages for the data once with a new toolkit, as an application would do.
+ */
+bool runStages(const std::string &data, FileResult &result)
+{
+    Toolkit toolkit(false);
+    StageTimer timer;
+
+    // The stages within the calls are not nested
+    StageTimer toolkitStageTimer;
+    toolkit.SetStageHook([&](ToolkitStage stage, int pageIdx, bool end) {
+        if (!end) {
+            toolkitStageTimer.Start();
+            return;
+        }
+        result.m_stages[STAGE_PARSE + stage].Add(toolkitStageTimer.Stop());
+    });
+
+    Profiler::Reset();
+
+    timer.Start();
+    bool success = toolkit.LoadData(data);
+    result.m_stages[STAGE_LOAD] = timer.Stop();
+    if (!success) return false;
+
+    result.m_pageCount = toolkit.GetPageCount();
+    result.m_pageRenders.clear();
+    int i;
+    for (i = 1; i <= result.m_pageCount; i++) {
+        timer.Start();
+        std::string svgOutput = toolkit.RenderToSvg(i);
+        result.m_pageRenders.push_back(timer.Stop());
+        result.m_stages[STAGE_RENDER].Add(result.m_pageRenders.back());
+    }
+
+    timer.Start();
+    std::string midiOutput = toolkit.RenderToMidi();
+    result.m_stages[STAGE_MIDI] = timer.Stop();
+
+    timer.Start();
+    std::string meiOutput = toolkit.GetMEI();
+    result.m_stages[STAGE_MEI] = timer.Stop();
+
+    if (Profiler::IsEnabled()) result.m_profile = Profiler::GetSummary();
+
+    return true;
+}
+
+/**
+ * Return the peak resident set size of the process in kilobytes, or 0 when it is not available.
+ */
+long peakRss()
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    // Given in bytes on macOS
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// JSON output and comparison
+//----------------------------------------------------------------------------
+
+jsonxx::Object stageJson(const StageResult &result)
+{
+    jsonxx::Object o;
+    o << "time" << result.m_time;
+    o << "allocations" << (jsonxx::Number)result.m_allocations;
+    o << "allocatedBytes" << (jsonxx::Number)result.m_allocatedBytes;
+    return o;
+}
+
+jsonxx::Object fileJson(const FileResult &result)
+{
+    jsonxx::Object o;
+    o << "format" << result.m_format;
+    o << "pages" << result.m_pageCount;
+
+    jsonxx::Object stages;
+    int i;
+    for (i = 0; i < STAGE_COUNT; i++) stages << std::string(stageNames[i]) << stageJson(result.m_stages[i]);
+    o << "stages" << stages;
+
+    jsonxx::Array pageRenders;
+    for (i = 0; i < (int)result.m_pageRenders.size(); i++) {
+        pageRenders << result.m_pageRenders.at(i).m_time;
+    }
+    o << "pageRenders" << pageRenders;
+
+    jsonxx::Object profile;
+    if (!result.m_profile.empty() && profile.parse(result.m_profile)) o << "profile" << profile;
+    return o;
+}
+
+/**
+ * Compare the results with a baseline written by a previous run and print the differences.
+ * A stage regresses when its time or its number of allocations increases by more than the threshold (in percent).
+ * Differences of time below minTime (in milliseconds) are ignored since they are within the noise.
+ * Return the number of regressions.
+ */
+int compareWithBaseline(const jsonxx::Object &current, const jsonxx::Object &baseline, double threshold, double minTime)
+{
+    int regressions = 0;
+    const jsonxx::Object &currentFiles = current.get<jsonxx::Object>("files");
+    const jsonxx::Object &baselineFiles = baseline.get<jsonxx::Object>("files");
+
+    std::map<std::string, jsonxx::Value *>::const_iterator iter;
+    for (iter = currentFiles.kv_map().begin(); iter != currentFiles.kv_map().end(); ++iter) {
+        if (!baselineFiles.has<jsonxx::Object>(iter->first)) {
+            cerr << iter->first << ": not in the baseline" << endl;
+            continue;
+        }
+        const jsonxx::Object &stages = iter->second->get<jsonxx::Object>().get<jsonxx::Object>("stages");
+        const jsonxx::Object &baselineStages
+            = baselineFiles.get<jsonxx::Object>(iter->first).get<jsonxx::Object>("stages");
+        int i;
+        for (i = 0; i < STAGE_COUNT; i++) {
+            if (!stages.has<jsonxx::Object>(stageNames[i]) || !baselineStages.has<jsonxx::Object>(stageNames[i])) {
+                continue;
+            }
+            const jsonxx::Object &stage = stages.get<jsonxx::Object>(stageNames[i]);
+            const jsonxx::Object &baselineStage = baselineStages.get<jsonxx::Object>(stageNames[i]);
+            double time = (double)stage.get<jsonxx::Number>("time");
+            double baselineTime = (double)baselineStage.get<jsonxx::Number>("time");
+            double allocations = (double)stage.get<jsonxx::Number>("allocations");
+            double baselineAllocations = (double)baselineStage.get<jsonxx::Number>("allocations");
+
+            bool slower = (time - baselineTime > minTime) && (time > baselineTime * (1.0 + threshold / 100));
+            bool moreAllocations = (allocations > baselineAllocations * (1.0 + threshold / 100));
+            if (!slower && !moreAllocations) continue;
+
+            regressions++;
+            cerr << iter->first << " " << stageNames[i] << ":";
+            if (slower) {
+                cerr << StringFormat(" time %.3fms -> %.3fms (%+.1f%%)", baselineTime, time,
+                    (baselineTime > 0.0) ? (time / baselineTime - 1.0) * 100 : 100.0);
+            }
+            if (moreAllocations) {
+                cerr << StringFormat(" allocations %.0f -> %.0f", baselineAllocations, allocations);
+            }
+            cerr << endl;
+        }
+    }
+
+    if (baseline.has<jsonxx::Number>("peakRss") && current.has<jsonxx::Number>("peakRss")) {
+        double rss = (double)current.get<jsonxx::Number>("peakRss");
+        double baselineRss = (double)baseline.get<jsonxx::Number>("peakRss");
+        if (rss > baselineRss * (1.0 + threshold / 100)) {
+            regressions++;
+            cerr << StringFormat("peak RSS: %.0fkB -> %.0fkB", baselineRss, rss) << endl;
+        }
+    }
+
+    return regressions;
+}
+
+//----------------------------------------------------------------------------
+// Main
+//----------------------------------------------------------------------------
+
+void display_usage()
+{
+    cerr << "Verovio " << GetVersion() << " benchmark" << endl << endl;
+    cerr << "Example usage:" << endl << endl;
+    cerr << " verovio-benchmark [-n iterations] [-o outfile] [-b baseline] corpusdir" << endl << endl;
+    cerr << "Every MEI, Plain and Easy, DARMS, Humdrum or MusicXML file of the corpus directory is loaded, laid out"
+         << endl;
+    cerr << "and rendered. The time and the allocations of each stage are written as JSON." << endl << endl;
+
+    cerr << "Options" << endl;
+    cerr << " -b, --baseline=FILE        Compare the results with a JSON file written by a previous run" << endl;
+    cerr << " -n, --iterations=N         Run each file N times and keep the best times (default is 3)" << endl;
+    cerr << " -o, --outfile=FILE         Write the results to FILE (default is the standard output)" << endl;
+    cerr << " -r, --resources=PATH       Path to SVG resources (default is " << Resources::GetPath() << ")" << endl;
+    cerr << " --min-time=MS              Ignore the time differences below MS milliseconds (default is 1.0)" << endl;
+    cerr << " --threshold=PERCENT        Report the regressions above PERCENT (default is 10.0)" << endl;
+    cerr << " --help                     Display this message" << endl;
+}
+
+bool readFile(const std::string &filename, std::string &data)
+{
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!in.is_open()) return false;
+    data.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = 3;
+    std::string outfile;
+    std::string baselineFile;
+    double threshold = 10.0;
+    double minTime = 1.0;
+    int show_help = 0;
+
+    static struct option long_options[] = { { "baseline", required_argument, 0, 'b' },
+        { "help", no_argument, &show_help, 1 }, { "iterations", required_argument, 0, 'n' },
+        { "min-time", required_argument, 0, 0 }, { "outfile", required_argument, 0, 'o' },
+        { "resources", required_argument, 0, 'r' }, { "threshold", required_argument, 0, 0 }, { 0, 0, 0, 0 } };
+
+    int c;
+    int option_index = 0;
+    while ((c = getopt_long(argc, argv, "b:n:o:r:", long_options, &option_index)) != -1) {
+        switch (c) {
+            case 0:
+                if (strcmp(long_options[option_index].name, "min-time") == 0) {
+                    minTime = atof(optarg);
+                }
+                else if (strcmp(long_options[option_index].name, "threshold") == 0) {
+                    threshold = atof(optarg);
+                }
+                break;
+            case 'b': baselineFile = string(optarg); break;
+            case 'n': iterations = std::max(1, atoi(optarg)); break;
+            case 'o': outfile = string(optarg); break;
+            case 'r': Resources::SetPath(optarg); break;
+            default: display_usage(); exit(1);
+        }
+    }
+
+    if (show_help || (optind != argc - 1)) {
+        display_usage();
+        exit(show_help ? 0 : 1);
+    }
+    std::string corpusDir = string(argv[optind]);
+
+    if (!Resources::InitFonts()) {
+        cerr << "The music font could not be loaded; please check the contents of the resource directory." << endl;
+        exit(1);
+    }
+
+    // The warnings of the files would be timed with the stages
+    DisableLog();
+
+    std::vector<std::string> filenames;
+    ::DIR *dir = opendir(corpusDir.c_str());
+    if (!dir) {
+        cerr << "The corpus directory " << corpusDir << " could not be read." << endl;
+        exit(1);
+    }
+    dirent *pdir;
+    while ((pdir = readdir(dir))) {
+        if (pdir->d_name[0] == '.') continue;
+        filenames.push_back(pdir->d_name);
+    }
+    closedir(dir);
+    // Always the same order so that the runs can be compared
+    std::sort(filenames.begin(), filenames.end());
+
+    Toolkit toolkit(false);
+    jsonxx::Object files;
+    std::vector<std::string>::iterator iter;
+    for (iter = filenames.begin(); iter != filenames.end(); ++iter) {
+        std::string data;
+        std::string path = corpusDir + "/" + (*iter);
+        struct stat st;
+        if ((stat(path.c_str(), &st) != 0) || !S_ISREG(st.st_mode) || !readFile(path, data)) continue;
+
+        FileFormat format = toolkit.IdentifyInputFormat(data);
+        if (format == UNKNOWN) continue;
+
+        FileResult result;
+        int i;
+        for (i = 0; i < iterations; i++) {
+            FileResult iteration;
+            if (!runStages(data, iteration)) break;
+            if (i == 0) {
+                result = iteration;
+            }
+            else {
+                result.KeepMinTime(iteration);
+            }
+        }
+        if (i < iterations) {
+            cerr << (*iter) << ": the file could not be loaded" << endl;
+            continue;
+        }
+        result.m_format = formatName(format);
+        files << (*iter) << fileJson(result);
+
+        cerr << StringFormat("%s: %d page(s)", iter->c_str(), result.m_pageCount);
+        for (i = 0; i < STAGE_COUNT; i++) cerr << StringFormat(" %s %.3fms", stageNames[i], result.m_stages[i].m_time);
+        cerr << endl;
+    }
+
+    jsonxx::Object output;
+    output << "version" << GetVersion();
+    output << "iterations" << iterations;
+    output << "peakRss" << (jsonxx::Number)peakRss();
+    output << "files" << files;
+
+    if (outfile.empty()) {
+        cout << output.json() << endl;
+    }
+    else {
+        std::ofstream out(outfile.c_str());
+        if (!out.is_open()) {
+            cerr << "Unable to open " << outfile << " for writing." << endl;
+            exit(1);
+        }
+        out << output.json() << endl;
+    }
+
+    if (baselineFile.empty()) return 0;
+
+    std::string baselineData;
+    jsonxx::Object baseline;
+    if (!readFile(baselineFile, baselineData) || !baseline.parse(baselineData)
+        || !baseline.has<jsonxx::Object>("files")) {
+        cerr << "The baseline " << baselineFile << " could not be read." << endl;
+        exit(1);
+    }
+
+    int regressions = compareWithBaseline(output, baseline, threshold, minTime);
+    if (regressions > 0) {
+        cerr << regressions << " regression(s) compared to " << baselineFile << endl;
+        return 1;
+    }
+    cerr << "No regression compared to " << baselineFile << endl;
+    return 0;
+}
@@ -6,6 +6,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <assert.h>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -19,6 +20,7 @@
 
 //----------------------------------------------------------------------------
 
+#include "profiler.h"
 #include "style.h"
 #include "toolkit.h"
 #include "vrv.h"
@@ -122,6 +124,13 @@ void display_usage()
     cerr << " --ignore-layout            Ignore all encoded layout information (if any)" << endl;
     cerr << "                            and fully recalculate the layout" << endl;
 
+    cerr << " --incremental-layout       Cast off the pages incrementally when they are rendered" << endl;
+
+    cerr << " --layout-cache=DIR         Store the page and system breaks in the (existing) directory DIR and use" << endl;
+    cerr << "                            them when the same data is loaded again with the same options; only the" << endl;
+    cerr << "                            cast off is saved (the data is still parsed and the pages laid out) and" << endl;
+    cerr << "                            it is not used with --incremental-layout, --no-layout or encoded breaks" << endl;
+
     cerr << " --mdiv-xpath-query=QR      Set the xPath query for selecting the <mdiv> to be rendered;" << endl;
     cerr << "                            only one <mdiv> can be rendered" << endl;
 
@@ -130,6 +139,9 @@ void display_usage()
 
     cerr << " --page=PAGE                Select the page to engrave (default is 1)" << endl;
 
+    cerr << " --profile=FILE             Write the profile of the stages and of the functors as a Chrome trace" << endl;
+    cerr << "                            to FILE (Verovio has to be compiled with profiling)" << endl;
+
     cerr << " --spacing-linear=SP        Specify the linear spacing factor (default is " << DEFAULT_SPACING_LINEAR
          << ")" << endl;
 
@@ -156,6 +168,7 @@ int main(int argc, char **argv)
     string infile;
     string svgdir;
     string outfile;
+    string profilefile;
     string outformat = "svg";
     string font = "";
     vector<string> appXPathQueries;
@@ -168,6 +181,7 @@ int main(int argc, char **argv)
     int no_layout = 0;
     int hum_type = 0;
     int ignore_layout = 0;
+    int incremental_layout = 0;
     int no_justification = 0;
     int even_note_spacing = 0;
     int show_bounding_boxes = 0;
@@ -193,10 +207,12 @@ int main(int argc, char **argv)
         { "even-note-spacing", no_argument, &even_note_spacing, 1 }, { "font", required_argument, 0, 0 },
         { "format", required_argument, 0, 'f' }, { "help", no_argument, &show_help, 1 },
         { "hum-type", no_argument, &hum_type, 1 }, { "ignore-layout", no_argument, &ignore_layout, 1 },
+        { "incremental-layout", no_argument, &incremental_layout, 1 }, { "layout-cache", required_argument, 0, 0 },
         { "mdiv-xpath-query", required_argument, 0, 0 }, { "no-layout", no_argument, &no_layout, 1 },
         { "no-mei-hdr", no_argument, &no_mei_hdr, 1 }, { "no-justification", no_argument, &no_justification, 1 },
         { "outfile", required_argument, 0, 'o' }, { "page", required_argument, 0, 0 },
         { "page-height", required_argument, 0, 'h' }, { "page-width", required_argument, 0, 'w' },
+        { "profile", required_argument, 0, 0 },
         { "resources", required_argument, 0, 'r' }, { "scale", required_argument, 0, 's' },
         { "show-bounding-boxes", no_argument, &show_bounding_boxes, 1 }, { "spacing-linear", required_argument, 0, 0 },
         { "spacing-non-linear", required_argument, 0, 0 }, { "spacing-staff", required_argument, 0, 0 },
@@ -220,6 +236,9 @@ int main(int argc, char **argv)
                 if (strcmp(long_options[option_index].name, "font") == 0) {
                     font = string(optarg);
                 }
+                else if (strcmp(long_options[option_index].name, "layout-cache") == 0) {
+                    toolkit.SetLayoutCacheDir(string(optarg));
+                }
                 else if (strcmp(long_options[option_index].name, "mdiv-xpath-query") == 0) {
                     cout << string(optarg) << endl;
                     toolkit.SetMdivXPathQuery(string(optarg));
@@ -227,6 +246,9 @@ int main(int argc, char **argv)
                 else if (strcmp(long_options[option_index].name, "page") == 0) {
                     page = atoi(optarg);
                 }
+                else if (strcmp(long_options[option_index].name, "profile") == 0) {
+                    profilefile = string(optarg);
+                }
                 else if (strcmp(long_options[option_index].name, "spacing-linear") == 0) {
                     if (!toolkit.SetSpacingLinear(atof(optarg))) {
                         exit(1);
@@ -324,10 +346,16 @@ int main(int argc, char **argv)
     toolkit.SetNoLayout(no_layout);
     toolkit.SetHumType(hum_type);
     toolkit.SetIgnoreLayout(ignore_layout);
+    toolkit.SetIncrementalLayout(incremental_layout);
     toolkit.SetNoJustification(no_justification);
     toolkit.SetEvenNoteSpacing(even_note_spacing);
     toolkit.SetShowBoundingBoxes(show_bounding_boxes);
 
+    if (!profilefile.empty() && !Profiler::IsEnabled()) {
+        cerr << "Verovio was compiled without profiling; please use the PROFILING option of CMake." << endl;
+        exit(1);
+    }
+
     if (optind <= argc - 1) {
         infile = string(argv[optind]);
     }
@@ -422,7 +450,8 @@ int main(int argc, char **argv)
 
     if (outformat == "svg") {
         int p;
-        for (p = from; p < to; p++) {
+        // The page count can change when the pages are cast off incrementally
+        for (p = from; p < (all_pages ? toolkit.GetPageCount() + 1 : to); p++) {
             std::string cur_outfile = outfile;
             if (all_pages) {
                 cur_outfile += StringFormat("_%03d", p);
@@ -443,8 +472,10 @@ int main(int argc, char **argv)
     else if (outformat == "midi") {
         outfile += ".mid";
         if (std_output) {
-            cerr << "Midi cannot write to standard output." << endl;
-            exit(1);
+            if (!toolkit.RenderToMidi(cout)) {
+                cerr << "Unable to write MIDI to standard output." << endl;
+                exit(1);
+            }
         }
         else if (!toolkit.RenderToMidiFile(outfile)) {
             cerr << "Unable to write MIDI to " << outfile << "." << endl;
@@ -496,5 +527,15 @@ int main(int argc, char **argv)
         }
     }
 
+    if (!profilefile.empty()) {
+        std::ofstream profile(profilefile.c_str());
+        if (!profile.is_open()) {
+            cerr << "Unable to write the profile to " << profilefile << "." << endl;
+            exit(1);
+        }
+        profile << Profiler::GetTrace();
+        cerr << "Profile written to " << profilefile << "." << endl;
+    }
+
     return 0;
 }